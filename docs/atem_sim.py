@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""Minimal ATEM switcher simulator for testing the direct ATEM link.
+
+Answers the hello on UDP 9910, sends a state dump (InPr + TlIn/TlSr) and
+then cuts between inputs 1-3 every second. Unacknowledged packets are
+resent after 200 ms. Every 5th cut is withheld on its first send, so it
+only arrives through the resend path.
+
+    python3 atem_sim.py [bind-address]
+
+then set sanctuary/tally/config/atem_address to this machine's IP.
+"""
+import socket
+import struct
+import sys
+import time
+
+SESSION = 0x8001
+
+
+def header(flags, length, session, packet_id=0):
+    return struct.pack(">HHHHHH", (flags << 11) | length, session, 0, 0, 0, packet_id)
+
+
+def command(name, data):
+    return struct.pack(">HH4s", 8 + len(data), 0, name) + data
+
+
+def inpr(input_id, short, long_name, internal_port=0):
+    body = struct.pack(">H20s4s", input_id, long_name.encode(), short.encode())
+    return command(b"InPr", body + bytes(6) + bytes([internal_port]) + bytes(3))
+
+
+def tally(program, preview):
+    def flags(i):
+        return (1 if i == program else 0) | (2 if i == preview else 0)
+    sources = [1, 2, 3, 1000]
+    tl_in = struct.pack(">H", 3) + bytes(flags(i) for i in (1, 2, 3))
+    tl_sr = struct.pack(">H", len(sources)) + b"".join(
+        struct.pack(">HB", s, flags(s)) for s in sources)
+    return command(b"TlIn", tl_in) + command(b"TlSr", tl_sr)
+
+
+def main():
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind((sys.argv[1] if len(sys.argv) > 1 else "0.0.0.0", 9910))
+    sock.settimeout(0.05)
+
+    client, next_id, unacked = None, 1, {}
+    program, preview, cuts, last_cut = 1, 2, 0, 0.0
+
+    def reliable(payload, lose=False):
+        nonlocal next_id
+        pkt = header(0x01, 12 + len(payload), SESSION, next_id) + payload
+        unacked[next_id] = [pkt, time.time()]
+        next_id = (next_id + 1) & 0x7FFF
+        if not lose:
+            sock.sendto(pkt, client)
+
+    while True:
+        try:
+            data, addr = sock.recvfrom(2048)
+            flags = data[0] >> 3
+            if flags & 0x02:                      # hello
+                client, next_id, unacked = addr, 1, {}
+                print("hello from", addr)
+                sock.sendto(header(0x02, 20, 0x53AB) + bytes([2]) + bytes(7), client)
+                reliable(inpr(1, "CTR", "Center Cam") + inpr(2, "LFT", "Left Cam") +
+                         inpr(3, "RGT", "Right Cam") + inpr(3010, "MP1", "Media 1", 4))
+                reliable(tally(program, preview))
+            elif flags & 0x10:                    # ack
+                unacked.pop(struct.unpack(">H", data[4:6])[0], None)
+        except socket.timeout:
+            pass
+
+        now = time.time()
+        if client and now - last_cut > 1.0:
+            last_cut, cuts = now, cuts + 1
+            program, preview = cuts % 3 + 1, (cuts + 1) % 3 + 1
+            reliable(tally(program, preview), lose=(cuts % 5 == 0))
+            print("cut: program", program, "preview", preview,
+                  "(lost, will resend)" if cuts % 5 == 0 else "")
+        for pid, entry in list(unacked.items()):
+            if now - entry[1] > 0.2:
+                sock.sendto(entry[0], client)
+                entry[1] = now
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <M5Unified.h>
+#include "ConfigState.h"
+#include "TallyState.h"
+
+// Optional direct connection to an ATEM switcher (Blackmagic UDP control
+// protocol, port 9910), bypassing Companion and the broker for tally.
+//
+// Read-only client: handshakes, ACKs the switcher's reliable packets in
+// order (re-ACKing resends, dropping anything past a gap until the
+// switcher resends it), and parses just TlIn/TlSr (tally by index /
+// source, into ME1), AuxS (aux 1-3) and InPr (input names). Receive
+// buffer and session state are static; nothing is allocated per packet. While the session is up it
+// owns program/preview and the input table, and the sanctuary/atem/*
+// topics are ignored.
+
+enum class AtemLink : uint8_t {
+    Off,          // atem_address not set, or no Wi-Fi
+    Connecting,   // hello sent, waiting for the switcher
+    Up
+};
+
+// Open/close the session as Wi-Fi and config change, and apply whatever
+// the switcher sent. Call from loop().
+void atem_onLoop(const ConfigState& cfg, TallyState& tally);
+
+AtemLink    atem_link();
+const char* atem_linkName();     // "off" / "connecting" / "up"
+uint32_t    atem_resends();      // switcher resends (duplicates) since boot
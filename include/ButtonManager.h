@@ -1,15 +1,23 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "SpscQueue.h"
 
-constexpr const uint32_t LONG_PRESS_DEFAULT_MS = 500;
+// NOTE: everything above ButtonManager is plain C++ (no Arduino headers),
+// so the queue and per-button state machine can be exercised on a host.
+
+constexpr const uint32_t LONG_PRESS_DEFAULT_MS   = 500;
+constexpr const uint32_t DOUBLE_CLICK_DEFAULT_MS = 0;      // 0 = disabled (no short-press delay)
+constexpr const uint32_t DEBOUNCE_DEFAULT_US     = 20000;  // 20 ms, applied in the ISR
 
 // Which button generated the event
 enum class ButtonID : uint8_t {
     None = 0,
     A,
     B,
-    // Power,   // reserved for future
+    Power,     // AXP192 PEK key
 };
 
 // What kind of press it was
@@ -17,38 +25,168 @@ enum class ButtonType : uint8_t {
     None = 0,
     ShortPress,
     LongPress,
+    DoubleClick,
+    Chord,      // id + other held together
 };
 
 // Single button event emitted from ButtonManager::poll()
 struct ButtonEvent {
     ButtonID   id       = ButtonID::None;
     ButtonType type     = ButtonType::None;
+    ButtonID   other    = ButtonID::None;   // second button for Chord
+    uint32_t   atMs     = 0;                // edge time the event was decided on
+};
+
+// Debounced edge captured in the GPIO ISR (or synthesized for the PEK key)
+struct ButtonEdge {
+    ButtonID id     = ButtonID::None;
+    bool     down   = false;
+    uint32_t atMs   = 0;                    // ISR timestamp
+};
+
+// Debounce in the ISR time domain: accept an edge only if the level really
+// changed and the last accepted one is at least debounceUs old. Updates
+// lastDown/lastUs when accepted. Runs inside the IRAM ISR.
+ISR_INLINE bool debounceEdge(bool down, int64_t nowUs, bool& lastDown, int64_t& lastUs,
+                             int64_t debounceUs = DEBOUNCE_DEFAULT_US) {
+    if (down == lastDown || nowUs - lastUs < debounceUs) {
+        return false;
+    }
+    lastDown = down;
+    lastUs   = nowUs;
+    return true;
+}
+
+// Per-button press state machine, shared by A, B and the PEK key.
+// Fed debounced edges plus a periodic tick(); all times are in ms.
+template <ButtonID Id>
+class ButtonStateMachine {
+public:
+    void configure(uint32_t longPressMs, uint32_t doubleClickMs) {
+        _longPressMs   = longPressMs;
+        _doubleClickMs = doubleClickMs;
+        reset();
+    }
+
+    void reset() {
+        _state  = State::Idle;
+        _downAt = 0;
+        _upAt   = 0;
+    }
+
+    // Pressed and still undecided (candidate for a chord)
+    bool isPending() const { return _state == State::Down; }
+    bool isDown() const {
+        return _state == State::Down || _state == State::LongFired ||
+               _state == State::SecondDown || _state == State::Suppressed;
+    }
+
+    // Swallow everything until the button is released (used for chords)
+    void suppress() {
+        if (isDown()) _state = State::Suppressed;
+    }
+
+    ButtonType onEdge(bool down, uint32_t atMs) {
+        switch (_state) {
+            case State::Idle:
+                if (down) { _state = State::Down; _downAt = atMs; }
+                break;
+
+            case State::Down:
+                if (!down) {
+                    if (atMs - _downAt >= _longPressMs) {
+                        // Threshold crossed between ticks
+                        _state = State::Idle;
+                        return ButtonType::LongPress;
+                    }
+                    if (_doubleClickMs == 0) {
+                        _state = State::Idle;
+                        return ButtonType::ShortPress;
+                    }
+                    _state = State::WaitSecond;
+                    _upAt  = atMs;
+                }
+                break;
+
+            case State::WaitSecond:
+                if (down) {
+                    if (atMs - _upAt < _doubleClickMs) {
+                        _state = State::SecondDown;
+                    } else {
+                        // Tick was late; first click stands, this starts a new press
+                        _state  = State::Down;
+                        _downAt = atMs;
+                        return ButtonType::ShortPress;
+                    }
+                }
+                break;
+
+            case State::SecondDown:
+                if (!down) { _state = State::Idle; return ButtonType::DoubleClick; }
+                break;
+
+            case State::LongFired:
+            case State::Suppressed:
+                if (!down) _state = State::Idle;
+                break;
+        }
+        return ButtonType::None;
+    }
+
+    ButtonType tick(uint32_t nowMs) {
+        if (_state == State::Down && nowMs - _downAt >= _longPressMs) {
+            _state = State::LongFired;      // fire immediately while still held
+            return ButtonType::LongPress;
+        }
+        if (_state == State::WaitSecond && nowMs - _upAt >= _doubleClickMs) {
+            _state = State::Idle;
+            return ButtonType::ShortPress;
+        }
+        return ButtonType::None;
+    }
+
+    static constexpr ButtonID id() { return Id; }
+
+private:
+    enum class State : uint8_t { Idle, Down, LongFired, WaitSecond, SecondDown, Suppressed };
+
+    State    _state         = State::Idle;
+    uint32_t _downAt        = 0;
+    uint32_t _upAt          = 0;
+    uint32_t _longPressMs   = LONG_PRESS_DEFAULT_MS;
+    uint32_t _doubleClickMs = DOUBLE_CLICK_DEFAULT_MS;
 };
 
 class ButtonManager {
 public:
-    // Configure how long (in ms) a press must be held to count as "long"
-    void begin(uint32_t longPressMs = LONG_PRESS_DEFAULT_MS);
+    // Configure thresholds and attach the GPIO edge interrupts.
+    void begin(uint32_t longPressMs = LONG_PRESS_DEFAULT_MS,
+               uint32_t doubleClickMs = DOUBLE_CLICK_DEFAULT_MS);
 
-    // Call once per loop *after* M5.update().
+    // Call once per loop *after* M5.update() (the PEK key is read there).
+    // Drains ISR edges, so a slow loop delays events but never drops them.
     // Returns ButtonEvent with type==None when no event.
     ButtonEvent poll();
 
+    // Edges lost because the ISR queue was full
+    uint32_t droppedEdges() const { return _edges.dropped(); }
+
+    // Called from the GPIO ISR
+    ISR_INLINE void pushEdge(const ButtonEdge& e) { _edges.push(e); }
+
 private:
-    uint32_t _longPressMs = LONG_PRESS_DEFAULT_MS;
+    ButtonStateMachine<ButtonID::A>     _a;
+    ButtonStateMachine<ButtonID::B>     _b;
+    ButtonStateMachine<ButtonID::Power> _pwr;
 
-    // Simple state for A
-    bool     _aWasDown    = false;
-    uint32_t _aDownAtMs   = 0;
+    SpscQueue<ButtonEdge, 16>  _edges;    // ISR -> loop
+    SpscQueue<ButtonEvent, 8>  _events;   // decided events waiting for poll()
 
-    // Simple state for B
-    bool     _bWasDown    = false;
-    uint32_t _bDownAtMs   = 0;
+    uint32_t _longPressMs = LONG_PRESS_DEFAULT_MS;
 
     // Internal helpers
-    ButtonEvent handleButtonA(bool isDown, uint32_t nowMs);
-    ButtonEvent handleButtonB(bool isDown, uint32_t nowMs);
-
-    bool _aLongPressFired;
-    bool _bLongPressFired;
-};
\ No newline at end of file
+    void handleEdge(const ButtonEdge& e);
+    void reconcileLevels(uint32_t nowMs);
+    void pollPowerKey(uint32_t nowMs);
+    void emit(ButtonID id, ButtonType type, uint32_t atMs, ButtonID other = ButtonID::None);
+};
@@ -9,6 +9,7 @@ class TallyState;
 // - BtnA short  -> cycle ATEM input (TallyState::selectNextInput)
 // - BtnB short  -> cycle brightness
 // - BtnB long   -> change screen
+// - BtnA+BtnB   -> back to the tally screen (chord)
 class ButtonRouter {
 public:
     ButtonRouter(ConfigState& cfg, TallyState& tally);
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "SpscQueue.h"
+
+// NOTE: plain C++ (no Arduino headers) so it can be exercised on a host.
+
+// Commands that higher-level code should respond to
+enum class MqttCommandType : uint8_t {
+    None,
+    DeepSleep,
+    Wakeup,
+    Reboot,
+    OtaUpdate,
+    FactoryReset,
+    ResyncTime,
+    selectNextInput,
+    Count_             // keep last
+};
+
+struct MqttCommand {
+    MqttCommandType type = MqttCommandType::None;
+    uint32_t seq         = 0;   // device-assigned, increasing per received command
+    uint32_t id          = 0;   // optional sender-supplied id (0 = none), echoed in the ack
+    uint32_t receivedMs  = 0;   // millis() when routed, for ack latency
+};
+
+// How a command ended up; reported on .../cmd/ack
+enum class CommandAckStatus : uint8_t {
+    Done,
+    Coalesced,    // identical command already pending; that one will run
+    Dropped,      // queue full
+    Ignored       // received but not implemented in this firmware
+};
+
+// Wire names ("reboot", "select_next_input", ...)
+const char* commandName(MqttCommandType type);
+const char* commandAckStatusName(CommandAckStatus status);
+
+// Bounded lock-free command queue between the MQTT router (producer) and
+// loop() (consumer). Every command gets a sequence number; idempotent
+// commands (everything except select_next_input, which steps) are
+// coalesced while one of the same type is still pending.
+class CommandQueue {
+public:
+    static constexpr size_t CAPACITY = 8;
+
+    enum class PushResult : uint8_t { Queued, Coalesced, Full };
+
+    // Assigns cmd.seq. Producer side only.
+    PushResult push(MqttCommand& cmd) {
+        cmd.seq = ++_nextSeq;
+
+        const uint32_t bit = typeBit(cmd.type);
+        if (isIdempotent(cmd.type) &&
+            (_pendingMask.load(std::memory_order_acquire) & bit)) {
+            return PushResult::Coalesced;
+        }
+        if (!_queue.push(cmd)) {
+            return PushResult::Full;
+        }
+        _pendingMask.fetch_or(bit, std::memory_order_release);
+        return PushResult::Queued;
+    }
+
+    // Consumer side only.
+    bool pop(MqttCommand& out) {
+        if (!_queue.pop(out)) {
+            return false;
+        }
+        _pendingMask.fetch_and(~typeBit(out.type), std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const { return _queue.empty(); }
+
+    static bool isIdempotent(MqttCommandType type) {
+        return type != MqttCommandType::selectNextInput;
+    }
+
+private:
+    static uint32_t typeBit(MqttCommandType type) {
+        return 1u << static_cast<uint8_t>(type);
+    }
+
+    SpscQueue<MqttCommand, CAPACITY> _queue;
+    std::atomic<uint32_t> _pendingMask{0};   // types currently in the queue
+    uint32_t _nextSeq = 0;
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <M5Unified.h>
+#include <ArduinoJson.h>
+#include <type_traits>
+#include "ConfigState.h"
+
+// Config keys are described once, in the table in ConfigSchema.cpp: name,
+// scope, type, range, default, where the value lives in ConfigState and
+// what applying it implies. MQTT routing, validation, NVS persistence and
+// the config echo are all driven from that table, so adding a key is a
+// ConfigState field plus one table row.
+
+enum class ConfigScope : uint8_t {
+    Global,   // sanctuary/tally/config/<key>
+    Device    // sanctuary/tally/{device}/config/<key>
+};
+
+enum class ConfigType : uint8_t {
+    Str,
+    Bool,
+    U8,
+    U16,
+    I8,
+    I16,
+    Enum      // uint8_t-backed enum class, set by name
+};
+
+// Numeric value outside [min, max]
+enum class ConfigRange : uint8_t {
+    Clamp,    // pull it into range
+    Reject,   // keep the current value
+    Default   // use the key's default
+};
+
+// Descriptor flags
+enum ConfigFlag : uint8_t {
+    CFG_PERSIST   = 1 << 0,   // kept in NVS, restored at boot
+    CFG_SECRET    = 1 << 1,   // never echoed
+    CFG_RESTART   = 1 << 2,   // only read at startup; takes effect after a reboot
+    CFG_TIME      = 1 << 3,   // re-run time setup (NTP server / timezone)
+    CFG_BUS_RULES = 1 << 4,   // re-evaluate the tally bus rules
+    CFG_INPUT     = 1 << 5    // resync the selected input
+};
+
+// FNV-1a, usable in constant expressions (C++11: recursion only)
+constexpr uint32_t configKeyHash(const char* s, uint32_t h = 2166136261u) {
+    return *s ? configKeyHash(s + 1, (h ^ static_cast<uint8_t>(*s)) * 16777619u) : h;
+}
+
+struct ConfigKeyDesc {
+    const char*        name;
+    uint32_t           hash;       // configKeyHash(name)
+    ConfigScope        scope;
+    ConfigType         type;
+    ConfigRange        range;
+    int32_t            min;
+    int32_t            max;
+    int32_t            def;        // numeric / bool / enum default
+    const char*        defText;    // Str default
+    const char* const* names;      // Enum: names by value, nullptr-terminated
+    uint8_t            flags;
+    void*            (*field)(ConfigState& cfg);
+};
+
+// ConfigType for a field's C++ type; enums map to Enum
+template <typename T, bool = std::is_enum<T>::value> struct ConfigTypeOf;
+template <typename T> struct ConfigTypeOf<T, true> {
+    static_assert(sizeof(T) == 1, "config enums must be uint8_t-backed");
+    static constexpr ConfigType value = ConfigType::Enum;
+};
+template <> struct ConfigTypeOf<String, false>   { static constexpr ConfigType value = ConfigType::Str; };
+template <> struct ConfigTypeOf<bool, false>     { static constexpr ConfigType value = ConfigType::Bool; };
+template <> struct ConfigTypeOf<uint8_t, false>  { static constexpr ConfigType value = ConfigType::U8; };
+template <> struct ConfigTypeOf<uint16_t, false> { static constexpr ConfigType value = ConfigType::U16; };
+template <> struct ConfigTypeOf<int8_t, false>   { static constexpr ConfigType value = ConfigType::I8; };
+template <> struct ConfigTypeOf<int16_t, false>  { static constexpr ConfigType value = ConfigType::I16; };
+
+struct ConfigApplyResult {
+    const ConfigKeyDesc* desc = nullptr;   // nullptr: unknown key
+    bool accepted = false;                 // false: value rejected
+    bool changed  = false;
+};
+
+// All descriptors
+const ConfigKeyDesc* configSchema_table(size_t& count);
+
+// O(1) lookup by scope and key name; nullptr if unknown
+const ConfigKeyDesc* configSchema_find(ConfigScope scope, const String& key);
+
+// Parse, validate and store one value (payload text as sent over MQTT).
+// An empty payload resets the key to its default.
+ConfigApplyResult configSchema_apply(ConfigState& cfg, ConfigScope scope,
+                                     const String& key, const String& payload);
+ConfigApplyResult configSchema_set(ConfigState& cfg, const ConfigKeyDesc& desc,
+                                   const String& text);
+
+// Current value as payload text (what configSchema_set() accepts)
+String configSchema_format(const ConfigState& cfg, const ConfigKeyDesc& desc);
+
+// {"global":{...},"device":{...}} with typed values, secrets left out
+String configSchema_echo(const ConfigState& cfg);
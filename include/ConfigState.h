@@ -28,6 +28,14 @@ enum class LogLevel : uint8_t {
     Debug
 };
 
+// How periodic status goes out: one topic per value, or one status/batch
+// document per interval
+enum class StatusEncoding : uint8_t {
+    Topics,
+    Json,
+    MsgPack
+};
+
 namespace ConfigDefaults {
     // MQTT / network / time
     constexpr const char* MQTT_SERVER   = "127.0.0.1";
@@ -36,6 +44,13 @@ namespace ConfigDefaults {
     constexpr const char* MQTT_PASSWORD = "";
     constexpr const char* NTP_SERVER_DEFAULT    = "us.pool.ntp.org";
     constexpr const char* TIMEZONE      = "Etc/UTC"; // Example time zones: "America/Chicago", "GMT-6"
+    constexpr uint16_t    RECONNECT_WINDOW_SEC = 0;    // 0 = plain jittered backoff
+    constexpr uint16_t    PUBLISH_RATE_PER_SEC = 20;   // outbound state publishes/s
+    constexpr const char* UDP_TALLY_GROUP      = "";   // multicast fast path, "" = off
+    constexpr uint16_t    UDP_TALLY_PORT       = 5599;
+    constexpr const char* ATEM_ADDRESS         = "";   // direct switcher link, "" = off
+    constexpr uint16_t    TSL_PORT             = 0;    // TSL UMD listener, 0 = off
+    constexpr int16_t     TSL_INDEX_OFFSET     = 0;    // input = TSL index + offset
 
     // Display / brightness
     constexpr uint8_t BRIGHTNESS             = 50;             // normal mode brightness (default 50%)
@@ -45,6 +60,9 @@ namespace ConfigDefaults {
     // Tally colors
     constexpr const char* TALLY_COLOR_PROGRAM = "#FF0000";
     constexpr const char* TALLY_COLOR_PREVIEW = "#00FF00";
+    constexpr uint16_t    TALLY_COALESCE_MS   = 20;   // program/preview pairing window
+    constexpr const char* TALLY_PROGRAM_BUSES = "me1,me2,me3,me4,ssrc";   // red if on any of these
+    constexpr const char* TALLY_PREVIEW_BUSES = "me1,me2,me3,me4";        // green if on any of these
 
     // Device-specific
     constexpr const char* FRIENDLY_NAME = "CamX";
@@ -57,6 +75,8 @@ namespace ConfigDefaults {
 
     // Status interval (seconds)
     constexpr uint16_t STATUS_INTERVAL_SEC = DEFAULT_STATUS_INTERVAL_SEC;
+    constexpr StatusEncoding STATUS_ENCODING = StatusEncoding::Topics;
+    constexpr bool           CONFIG_ECHO     = false;   // publish status/config after changes
 
     // Idle dimming (seconds of no activity before dim)
     constexpr uint16_t IDLE_DIM_SECONDS = 60;
@@ -76,6 +96,23 @@ struct GlobalConfig {
     String ntpServer = ConfigDefaults::NTP_SERVER_DEFAULT;
     String timeZone = ConfigDefaults::TIMEZONE;
 
+    // Server-advertised slot width for spreading reconnects after a broker bounce
+    uint16_t reconnectWindowSec = ConfigDefaults::RECONNECT_WINDOW_SEC;
+
+    // Cap on outbound state publishes (bounds radio TX during bursts)
+    uint16_t publishRatePerSec = ConfigDefaults::PUBLISH_RATE_PER_SEC;
+
+    // UDP multicast tally fast path (group "" = disabled)
+    String   udpTallyGroup = ConfigDefaults::UDP_TALLY_GROUP;
+    uint16_t udpTallyPort  = ConfigDefaults::UDP_TALLY_PORT;
+
+    // Direct ATEM connection (IP address, "" = use the sanctuary/atem/* topics)
+    String   atemAddress = ConfigDefaults::ATEM_ADDRESS;
+
+    // TSL UMD listener (UDP + TCP on one port, 0 = off)
+    uint16_t tslPort        = ConfigDefaults::TSL_PORT;
+    int16_t  tslIndexOffset = ConfigDefaults::TSL_INDEX_OFFSET;
+
     // Display / tally brightness (0–100 logical scale)
     // These are "percent-ish" values that map directly into ScreenBreath(0–100).
     uint8_t brightness = ConfigDefaults::BRIGHTNESS;
@@ -85,10 +122,19 @@ struct GlobalConfig {
     String tallyColorProgram = ConfigDefaults::TALLY_COLOR_PROGRAM;
     String tallyColorPreview = ConfigDefaults::TALLY_COLOR_PREVIEW;
 
+    // How long a program/preview change waits for its counterpart (0 = off)
+    uint16_t tallyCoalesceMs = ConfigDefaults::TALLY_COALESCE_MS;
+
+    // Tally rules: which buses make a source red / green (see TallyBus)
+    String tallyProgramBuses = ConfigDefaults::TALLY_PROGRAM_BUSES;
+    String tallyPreviewBuses = ConfigDefaults::TALLY_PREVIEW_BUSES;
+
     // Wi-Fi tuning
     int8_t wifiTxPowerDbm = ConfigDefaults::WIFI_TX_POWER_DBM;       
     WifiSleepMode wifiSleep = ConfigDefaults::WIFI_SLEEP;
     uint16_t statusIntervalSec = ConfigDefaults::STATUS_INTERVAL_SEC;
+    StatusEncoding statusEncoding = ConfigDefaults::STATUS_ENCODING;
+    bool configEcho = ConfigDefaults::CONFIG_ECHO;
 
     // Idle dimming
     uint16_t idleDimSeconds = ConfigDefaults::IDLE_DIM_SECONDS;
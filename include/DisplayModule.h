@@ -1 +1,26 @@
-void cycleBrightness();
\ No newline at end of file
+#pragma once
+
+#include <M5Unified.h>
+
+void cycleBrightness();
+
+// --- Display push timing ---------------------------------------
+//
+// pushSprite() is synchronous: the loop is blocked for about the whole
+// frame transfer. A full 240x135 frame is ~520 kbit, i.e. roughly 13 ms at
+// a 40 MHz SPI clock; status/display_blocked_us reports the real figure.
+// Screens are not pushed by DMA: that needs RGB565 buffers, and the tally
+// screen is a 4-bit palette sprite to keep ~48 KB of heap free.
+
+// Time spent blocked on the panel, in microseconds.
+struct DisplayFrameStats {
+    uint32_t frames         = 0;
+    uint32_t lastBlockedUs  = 0;   // most recent frame
+    uint32_t maxBlockedUs   = 0;   // worst frame since last reset
+    uint32_t totalBlockedUs = 0;   // running total since boot
+};
+
+extern DisplayFrameStats displayStats;
+
+// Push a sprite to the panel and record how long that blocked.
+void display_push(LGFX_Sprite& sprite, int32_t x, int32_t y);
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <M5Unified.h>
+
+// MPU6886 wake-on-motion + FIFO driver.
+//
+// Instead of polling the accelerometer, the IMU raises its INT pin when
+// motion exceeds a threshold. Only then do we read a short FIFO burst and
+// hand back the averaged acceleration for orientation decisions.
+
+// Configure wake-on-motion interrupt and FIFO. Call after M5.begin().
+void imu_setup();
+
+// Returns true once per motion event, with the averaged acceleration (in g)
+// from a short FIFO burst taken right after the interrupt, and once more
+// with a direct read ~300 ms after the last event, once the device has come
+// to rest. Issues no I2C traffic while the device is still.
+bool imu_takeMotionSample(float& ax, float& ay, float& az);
+
+// One-shot synchronous read (initial orientation at boot).
+bool imu_readAccelNow(float& ax, float& ay, float& az);
@@ -2,11 +2,15 @@
 
 #include <M5Unified.h>
 #include <functional>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 #include "ConfigState.h"
 #include "TallyState.h"
+#include "CommandQueue.h"
+#include "PublishQueue.h"
 
-class WiFiClient;
-class PubSubClient;
+struct esp_mqtt_client;   // esp-mqtt handle (mqtt_client.h)
 
 struct StatusSnapshot {
     uint32_t uptimeSec = 0;
@@ -16,7 +20,26 @@ struct StatusSnapshot {
     uint8_t  batPercentageHybrid = 0;
     float    coulombCount = 0;
     int8_t   rssi = 0;
+    String   wifiConnectPath;          // "fast" / "scan" / "none"
+    uint32_t wifiConnectMs = 0;
+    uint32_t bootToTallyMs = 0;        // setup() start -> first live tally (0 = not yet)
     float    temperatureC = NAN;
+    uint32_t displayBlockedMaxUs = 0;  // worst per-frame panel wait since last status
+    uint32_t loopMaxMs = 0;            // worst gap between loop() passes since last status
+    uint32_t mqttBlockedMaxUs = 0;     // worst time loop() spent inside the MQTT client
+    uint32_t mqttRxDropped = 0;        // inbound messages dropped (queue full / no memory)
+    uint32_t mqttRecoverMs = 0;        // last outage: disconnect -> connected again (0 = none yet)
+    uint16_t mqttRecoverAttempts = 0;  // reconnect attempts that outage took
+    uint32_t mqttReplayed = 0;         // queued while offline, sent after reconnect
+    uint32_t mqttDropped = 0;          // superseded (state) or evicted (log/ack) while offline
+    uint32_t tallyCoalesced = 0;       // program/preview pairs applied together
+    uint32_t tallyCoalesceTimeouts = 0;// changes applied alone after the window
+    uint32_t udpTallyRx = 0;           // fast-path datagrams applied
+    uint32_t udpTallyRejected = 0;     // malformed / reordered datagrams
+    String   atemLink;                 // "off" / "connecting" / "up"
+    uint32_t atemResends = 0;          // duplicate packets from the switcher
+    uint32_t tslRx = 0;                // TSL UMD packets applied
+    uint32_t tslRejected = 0;          // malformed TSL packets
     uint32_t restartCount = 0;
     String   firmwareVersion;
     String   buildDateTime;   // from eff.buildDateTime (YYYYMMDDHHMMSS)
@@ -24,16 +47,21 @@ struct StatusSnapshot {
 };
 
 // Thin wrapper managing topics + callbacks.
+//
+// Transport is esp-mqtt, which runs connect/read/write in its own task.
+// Nothing here blocks loop(): publishes are enqueued into the esp-mqtt
+// outbox, inbound messages come back through a FreeRTOS queue drained in
+// loop(), and reconnects are requested, not performed, from loop().
 class MqttClient {
 public:
     using MessageHandler = std::function<void(const String& topic, const String& payload)>;
 
     MqttClient(ConfigState& cfg, TallyState& tally);
 
-    // Must be called from setup() after Wi-Fi is up.
+    // Call once Wi-Fi is up; the first connect completes asynchronously.
     void begin();
 
-    // Call from loop()
+    // Call from loop(): connection edges, inbound dispatch, reconnects.
     void loop();
 
     // Publish a status snapshot (will use ConfigState for topics)
@@ -49,42 +77,92 @@ public:
 
     void publishTallyColor(const String& color);
 
+    // Applied config as JSON (status/config), see configSchema_echo()
+    void publishConfigEcho(const String& json);
+
+    // Acknowledge a command on .../cmd/ack (JSON: seq, cmd, status, latency)
+    void publishCommandAck(const MqttCommand& cmd, CommandAckStatus status);
+
     // Set callback for *all* inbound topics we care about
     void setMessageHandler(MessageHandler handler) { _onMessage = handler; }
 
     bool isConnected() const { return _connected; }
 
+    // Worst time a loop()-side MQTT call took since the last call (µs)
+    uint32_t takeMaxBlockedUs();
+
+    uint32_t rxDropped() const { return _rxDropped.load(); }
+
+    // Store-and-forward counters (see PublishQueue)
+    uint32_t txReplayed() const { return _outbox.replayed(); }
+    uint32_t txDropped() const  { return _outbox.dropped(); }
+
+    // Last broker outage (disconnect -> connected), for fleet recovery timing
+    uint32_t lastRecoverMs() const { return _lastRecoverMs; }
+    uint16_t lastRecoverAttempts() const { return _lastRecoverAttempts; }
+
 private:
+    // One reassembled inbound message (topic and payload NUL-terminated)
+    struct InboundMessage {
+        char*    topic;
+        char*    payload;
+        uint32_t payloadLen;
+    };
+
     ConfigState& _cfg;
     TallyState&  _tally;
-    WiFiClient*  _wifiClient = nullptr;
-    PubSubClient* _mqtt = nullptr;
-    bool         _connected = false;
-    uint32_t     _lastReconnectAttemptMs = 0;
+    esp_mqtt_client* _client = nullptr;
+    bool         _connected = false;             // loop()-side view
+    std::atomic<bool> _transportUp{false};       // set from the MQTT task
+    uint32_t     _maxBlockedUs = 0;
+
+    // Reconnect backoff (exponential, full jitter). The RNG and the window
+    // slot are seeded from the device ID so a fleet spreads out instead of
+    // retrying in lockstep after a broker restart.
+    uint32_t     _rng = 0;
+    uint32_t     _deviceSlot = 0;
+    uint16_t     _reconnectAttempt = 0;
+    uint32_t     _nextReconnectAtMs = 0;
+    uint32_t     _outageStartMs = 0;
+    bool         _everConnected = false;
+    uint32_t     _lastRecoverMs = 0;
+    uint16_t     _lastRecoverAttempts = 0;
+
+    // Inbound path: MQTT task -> queue -> loop()
+    QueueHandle_t _rxQueue = nullptr;
+    InboundMessage* _rxPartial = nullptr;        // fragment reassembly (MQTT task only)
+    int          _prioritySubMsgId = -1;         // SUBACK that releases the other subscriptions
+    std::atomic<uint32_t> _rxDropped{0};
+
+    // Strings handed to esp-mqtt must outlive the client. _deviceRoot is
+    // fixed in begin() so the MQTT task never touches ConfigState.
+    String _deviceRoot;
+    String _clientId;
+    String _lwtTopic;
+    String _host;
+    String _username;
+    String _password;
 
     MessageHandler _onMessage;
 
-    // Debounce state for /status/input publishes
-    uint8_t  _pendingSelectedInput            = 0;
-    bool     _hasPendingSelectedInput         = false;
-    uint32_t _pendingSelectedInputChangedAtMs = 0;
-    uint8_t  _lastPublishedSelectedInput      = 0;
-
-    // Debounce state for /status/tally publishes
-    String   _pendingTallyColor;
-    bool     _hasPendingTallyColor            = false;
-    uint32_t _pendingTallyColorChangedAtMs    = 0;
-    String   _lastPublishedTallyColor;
+    // Outbound state topics and event streams; also buffers across disconnects
+    PublishQueue _outbox;
 
     // Internal helpers
     void setupClient();
-    void ensureConnected();
-    bool connectOnce();
-    void subscribeAll();
-
-    // PubSub callback
-    static void _mqttCallbackThunk(char* topic, uint8_t* payload, unsigned int length);
-    void handleIncoming(const char* topic, const uint8_t* payload, unsigned int length);
+    void subscribePriority();
+    void subscribeRest();
+    void publishRaw(const String& topic, const String& payload, bool retain);
+    void onConnected();
+    void noteBlocked(uint32_t startUs);
+    uint32_t nextRandom();
+    uint32_t reconnectDelayMs();
+    void scheduleReconnect();
+
+    // esp-mqtt event handler (runs in the MQTT task)
+    static void _mqttEventThunk(void* arg, const char* base, int32_t eventId, void* eventData);
+    void onData(const void* event);
+    void handleIncoming(const InboundMessage& msg);
 
     // Topic builders
     String topicDeviceRoot() const;       // sanctuary/tally/{device}
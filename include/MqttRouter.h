@@ -3,30 +3,21 @@
 #include <M5Unified.h>
 #include "ConfigState.h"
 #include "TallyState.h"
-
-// Commands that higher-level code should respond to
-enum class MqttCommandType : uint8_t {
-    None,
-    DeepSleep,
-    Wakeup,
-    Reboot,
-    OtaUpdate,
-    FactoryReset,
-    ResyncTime,
-    selectNextInput
-};
-
-struct MqttCommand {
-    MqttCommandType type = MqttCommandType::None;
-};
+#include "CommandQueue.h"
 
 // Route and handle a single MQTT message.
 // - Updates cfg and tally in-place
-// - Fills outCommand if a command (deep_sleep, reboot, etc.) was received
+// - Queues commands (deep_sleep, reboot, etc.) on `commands`; coalesced or
+//   dropped ones are acked right away, the rest after loop() runs them
 void handleMqttMessage(
     ConfigState& cfg,
     TallyState& tally,
     const String& topic,
     const String& payload,
-    MqttCommand& outCommand
+    CommandQueue& commands
 );
+
+// Config topics are not applied as they arrive: handleMqttMessage() only
+// records them, and this applies everything in one pass once the burst
+// (e.g. the retained dump after a reconnect) has settled. Call from loop().
+void serviceMqttConfig(ConfigState& cfg, TallyState& tally);
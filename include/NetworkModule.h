@@ -1,10 +1,8 @@
 #pragma once
 
 #include <M5Unified.h>
-#include <ezTime.h>        // set #define EZTIME_CACHE_NVS in this file
 #include <WiFiManager.h>
 
-extern Timezone localTime;
 extern WiFiManager wm;
 
 void WiFi_setup();
@@ -12,9 +10,12 @@ void WiFi_onLoop();
 void WiFi_onEvent(WiFiEvent_t event);
 void WiFi_onSaveParams();
 
-// Debounced time initialization API
-void requestTimeInit();
-void serviceTimeInit();
-
-// Optional: request a one-shot NTP resync via MQTT /cmd
-void requestTimeResync();
\ No newline at end of file
+// How the last WiFi_setup() got connected, and how long it took
+enum class WifiConnectPath : uint8_t {
+    None,       // not connected (portal / timeout)
+    Fast,       // cached BSSID + channel + static lease
+    Scan        // full scan + DHCP with the saved credentials
+};
+WifiConnectPath WiFi_connectPath();
+const char*     WiFi_connectPathName();
+uint32_t        WiFi_connectDurationMs();
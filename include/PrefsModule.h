@@ -2,9 +2,24 @@
 
 #include <M5Unified.h>
 #include "ConfigState.h"
+#include "TallyState.h"
 
 void preferences_setup();
 void preferences_save();
 void WiFi_onSaveParams();
 
-void prefs_applyToConfig(ConfigState& cfg);
\ No newline at end of file
+void prefs_applyToConfig(ConfigState& cfg);
+
+// Config keys marked CFG_PERSIST (see ConfigSchema.cpp), NVS namespace
+// "config". Load once at boot, before Wi-Fi; save after a config pass
+// changed any of them (only keys whose stored text differs are written).
+void prefs_loadConfig(ConfigState& cfg);
+void prefs_saveConfig(const ConfigState& cfg);
+
+// Warm-start tally cache: restore the last-known input table, selection,
+// program/preview and friendly name before the network is up. Returns true
+// if a snapshot was restored (TallyState::stale is then set).
+bool prefs_restoreTallySnapshot(TallyState& tally, ConfigState& cfg);
+
+// Call from loop(); persists the snapshot only when it has changed.
+void prefs_serviceTallySnapshot(const TallyState& tally, const ConfigState& cfg);
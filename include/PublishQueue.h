@@ -0,0 +1,145 @@
+#pragma once
+
+#include <M5Unified.h>
+#include <functional>
+
+// Outbound state topics, relative to sanctuary/tally/{device}/.
+// Order must match the descriptor table in PublishQueue.cpp.
+enum class PubTopic : uint8_t {
+    Availability,
+    StatusTally,
+    StatusInput,
+    StatusShortName,
+    StatusLongName,
+    StatusUptime,
+    StatusBatteryMv,
+    StatusBatteryPct,
+    StatusBatteryPctCoulomb,
+    StatusBatteryPctHybrid,
+    StatusCoulombCount,
+    StatusRssi,
+    StatusWifiConnectPath,
+    StatusWifiConnectMs,
+    StatusTemperature,
+    StatusBootToTallyMs,
+    StatusDisplayBlockedUs,
+    StatusLoopMaxMs,
+    StatusMqttBlockedUs,
+    StatusMqttRxDropped,
+    StatusMqttRecoverMs,
+    StatusMqttRecoverAttempts,
+    StatusMqttReplayed,
+    StatusMqttDropped,
+    StatusTallyCoalesced,
+    StatusTallyCoalesceTimeouts,
+    StatusUdpTallyRx,
+    StatusUdpTallyRejected,
+    StatusAtemLink,
+    StatusAtemResends,
+    StatusTslRx,
+    StatusTslRejected,
+    StatusRestarts,
+    StatusFirmwareVersion,
+    StatusBuildDateTime,
+    StatusHwRevision,
+    StatusBatch,
+    StatusConfig,
+    Count_
+};
+
+// Event streams: every message matters, kept in FIFO order
+enum class PubStream : uint8_t {
+    Log,        // status/log
+    CommandAck  // cmd/ack
+};
+
+// Per-topic publish policy
+struct PubTopicDesc {
+    const char* subtopic;        // below the device root
+    uint16_t    debounceMs;      // value must be stable this long before it goes out
+    uint8_t     priority;        // 0 = most urgent
+    bool        retain;
+    bool        suppressRepeat;  // skip if equal to the last value sent
+};
+
+// Coalescing outbound queue keyed by topic: at most one pending value per
+// topic (latest wins), debounced, deduplicated against the last value
+// sent, and drained highest-priority-first under a messages/second budget.
+// Bursts (e.g. rapid Btn-A cycling) collapse to one publish per topic.
+//
+// Also the store-and-forward buffer across disconnects: state keeps only
+// its latest value, event streams (log lines, command acks) go into a
+// fixed FIFO ring that drops the oldest entry when full. Whatever was
+// queued while offline is replayed after reconnect.
+//
+// Only the event streams are allocation-free. State slots hold their
+// value and last-sent copy in heap Strings, so set() and drain() may
+// allocate, the status batch and config document every status cycle.
+class PublishQueue {
+public:
+    using PublishFn = std::function<void(const char* subtopic, const String& value, bool retain)>;
+
+    static const PubTopicDesc& describe(PubTopic t);
+
+    static constexpr size_t   STREAM_CAPACITY = 32;
+    static constexpr size_t   STREAM_TEXT_MAX = 159;
+
+    // Record the latest value for a topic.
+    void set(PubTopic t, const String& value);
+
+    // Append an event (truncated to STREAM_TEXT_MAX). Drops the oldest
+    // entry when the ring is full.
+    void push(PubStream stream, const char* text);
+
+    // Connection state, for replay accounting and log age stamps
+    void setOnline(bool online) { _online = online; }
+
+    // Publish whatever is due, within the rate budget. Call from loop()
+    // while connected.
+    void drain(uint32_t nowMs, uint16_t ratePerSec, const PublishFn& publish);
+
+    // New session: forget what the broker has seen and queue every state
+    // topic (retained or suppressRepeat) that was sent before, so it is
+    // republished. Periodic status is left to the next status cycle.
+    void forgetSent();
+
+    uint32_t suppressed() const { return _suppressed; }
+    uint32_t replayed() const   { return _replayed; }   // sent after being queued offline
+    uint32_t dropped() const    { return _dropped; }    // overwritten/evicted while offline
+
+private:
+    struct Slot {
+        String   value;      // heap; the batch/config payloads are too
+        String   lastSent;   // large to give every slot inline storage
+        uint32_t changedAtMs = 0;
+        bool     pending     = false;
+        bool     everSent    = false;
+        bool     offline     = false;   // (last) set while disconnected
+    };
+
+    struct StreamEntry {
+        uint32_t  atMs;
+        PubStream stream;
+        bool      offline;
+        uint8_t   len;
+        char      text[STREAM_TEXT_MAX + 1];
+    };
+
+    bool publishStreamHead(uint32_t nowMs, const PublishFn& publish);
+
+    Slot     _slots[static_cast<size_t>(PubTopic::Count_)];
+    uint16_t _pendingCount = 0;
+    uint32_t _suppressed   = 0;
+
+    StreamEntry _stream[STREAM_CAPACITY];
+    uint16_t    _streamHead  = 0;   // oldest
+    uint16_t    _streamCount = 0;
+
+    bool     _online       = false;
+    uint32_t _replayed     = 0;
+    uint32_t _dropped      = 0;
+
+    // Token bucket, in thousandths of a message
+    uint32_t _tokensMilli  = 0;
+    uint32_t _lastRefillMs = 0;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// For code reached from an IRAM ISR: the GPIO ISR service runs with the
+// flash cache off during NVS writes, so a helper must be inlined into the
+// ISR rather than left as an out-of-line copy in flash. (std::atomic
+// members are always_inline in libstdc++.)
+#ifndef ISR_INLINE
+#define ISR_INLINE inline __attribute__((always_inline))
+#endif
+
+// Fixed-size lock-free ring for one producer and one consumer (e.g. the
+// GPIO ISRs, which share one dispatcher, feeding loop()). Plain C++.
+// push() is ISR-safe; T must be trivially copyable.
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert((N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+public:
+    ISR_INLINE bool push(const T& v) {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        const uint32_t tail = _tail.load(std::memory_order_acquire);
+        if (head - tail >= N) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;   // full
+        }
+        _buf[head & (N - 1)] = v;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& out) {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        const uint32_t head = _head.load(std::memory_order_acquire);
+        if (tail == head) {
+            return false;   // empty
+        }
+        out = _buf[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    T _buf[N];
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+    std::atomic<uint32_t> _dropped{0};
+};
@@ -10,15 +10,99 @@ struct AtemInputInfo {
     String shortName;    // e.g. "Cam1"
     String longName;     // e.g. "Cam1 Center - main follow"
     bool   tallyEnabled; // from "TRUE"/"FALSE"
+    uint8_t brightness = 3; // UMD lamp brightness from TSL, 0..3 (3 = full)
 };
 
+// Switcher buses a source can be on air through. ME1 also takes every
+// single-bus feed (sanctuary/atem/program|preview, UDP fast path, the
+// ATEM/TSL aggregate tally).
+enum class TallyBus : uint8_t {
+    ME1, ME2, ME3, ME4,
+    SuperSource,
+    Aux1, Aux2, Aux3,
+    Count_
+};
+static constexpr uint8_t TALLY_BUS_COUNT = static_cast<uint8_t>(TallyBus::Count_);
+
+// Set of buses (bit n = TallyBus n)
+static constexpr uint8_t tallyBusBit(TallyBus bus) {
+    return static_cast<uint8_t>(1u << static_cast<uint8_t>(bus));
+}
+
+// Default rules: red on any ME program or SuperSource, green on any ME
+// preview. Aux buses only count once a rule names them.
+static constexpr uint8_t TALLY_DEFAULT_PROGRAM_BUSES =
+    tallyBusBit(TallyBus::ME1) | tallyBusBit(TallyBus::ME2) |
+    tallyBusBit(TallyBus::ME3) | tallyBusBit(TallyBus::ME4) |
+    tallyBusBit(TallyBus::SuperSource);
+static constexpr uint8_t TALLY_DEFAULT_PREVIEW_BUSES =
+    tallyBusBit(TallyBus::ME1) | tallyBusBit(TallyBus::ME2) |
+    tallyBusBit(TallyBus::ME3) | tallyBusBit(TallyBus::ME4);
+
 struct TallyState {
     // Current program/preview input IDs from:
     //   sanctuary/atem/program
     //   sanctuary/atem/preview
+    // (With the combined topic: the lowest input on each bus set.)
     uint8_t programInput = 0;
     uint8_t previewInput = 0;
 
+    // Per-bus program/preview source sets: bit n = input n (1..63; the
+    // input ID is already a dense index). Aux buses only use program.
+    uint64_t busProgram[TALLY_BUS_COUNT] = {};
+    uint64_t busPreview[TALLY_BUS_COUNT] = {};
+
+    // Which buses make a source red / green (TallyBus bits), from the
+    // tally_program_buses / tally_preview_buses config keys
+    uint8_t  programBuses = TALLY_DEFAULT_PROGRAM_BUSES;
+    uint8_t  previewBuses = TALLY_DEFAULT_PREVIEW_BUSES;
+
+    // Rules applied to the bus sets; recomputed on every change so
+    // isProgram()/isPreview() are a single bit test
+    uint64_t programMask = 0;
+    uint64_t previewMask = 0;
+
+    // Once the combined topic has been seen the single topics are only a
+    // fallback and are ignored. combinedSeq rejects reordered updates.
+    bool     combinedActive = false;
+    uint32_t combinedSeq    = 0;
+
+    // UDP multicast fast path (UdpTallyModule). While datagrams keep
+    // arriving they own program/preview and the MQTT topics are ignored.
+    uint32_t fastSeq    = 0;
+    uint32_t fastLastMs = 0;
+    bool     fastSeen   = false;
+
+    // Direct ATEM session (AtemModule). While up it owns program/preview
+    // and the input table; MQTT tally topics and UDP datagrams are ignored.
+    bool     atemDirect = false;
+
+    // TSL UMD source (TslModule) is live: owns program/preview like the
+    // UDP fast path; labels still merge with sanctuary/atem/inputs.
+    bool     umdDirect  = false;
+
+    // Glitch filter for the single topics. A cut changes program and
+    // preview in two messages; rendering after the first shows a one-frame
+    // wrong color. A change is held until its counterpart arrives
+    // (coalesced) or the window runs out (timeout).
+    bool     heldProgram      = false;
+    bool     heldPreview      = false;
+    uint8_t  heldProgramInput = 0;
+    uint8_t  heldPreviewInput = 0;
+    uint32_t heldDeadlineMs   = 0;
+    uint32_t coalescedCount   = 0;   // pairs applied together
+    uint32_t coalesceTimeouts = 0;   // changes applied alone after the window
+
+    // Set once the (retained) program/preview topics have been received
+    bool programKnown = false;
+    bool previewKnown = false;
+
+    // True while program/preview come from the warm-start cache and have
+    // not yet been confirmed by MQTT. restoredEpoch is when they were saved
+    // (0 if the clock wasn't set then).
+    bool     stale         = false;
+    uint32_t restoredEpoch = 0;
+
     // Map from ATEM input ID → info (from sanctuary/atem/inputs JSON)
     std::map<uint8_t, AtemInputInfo> inputs;
 
@@ -26,6 +110,48 @@ struct TallyState {
     // 0 means "no selection".
     uint8_t selectedInput = 0;
 
+    // Update from the single program/preview topics (or the warm-start cache)
+    void setProgramInput(uint8_t input);
+    void setPreviewInput(uint8_t input);
+
+    // Update from sanctuary/atem/program / preview through the glitch
+    // filter. windowMs = 0 applies immediately.
+    void stageProgram(uint8_t input, uint32_t nowMs, uint16_t windowMs);
+    void stagePreview(uint8_t input, uint32_t nowMs, uint16_t windowMs);
+
+    // Apply a held change whose window has expired. Call from loop().
+    void serviceCoalesce(uint32_t nowMs);
+
+    // Apply all buses together from the combined topic (buses not listed
+    // are cleared). Returns false (and changes nothing) if seq is older
+    // than the last applied.
+    bool applyCombined(uint32_t seq, const uint64_t program[TALLY_BUS_COUNT],
+                       const uint64_t preview[TALLY_BUS_COUNT]);
+
+    // Apply a fast-path datagram. Returns false for duplicates (seq equal,
+    // which still counts as a heartbeat) and reordered packets.
+    bool applyFast(uint32_t seq, uint8_t program, uint8_t preview, uint32_t nowMs);
+
+    // Apply one bus from a direct source, ATEM or TSL (bit n = input n).
+    void applySets(uint64_t program, uint64_t preview, TallyBus bus = TallyBus::ME1);
+
+    // Clear every bus except keep. Called when a single-bus source takes
+    // over, so ME2-4 / SuperSource / Aux bits left by the combined topic
+    // or an ATEM session don't stay on air.
+    void resetBuses(TallyBus keep = TallyBus::ME1);
+
+    // Change the red/green rules (TallyBus bits).
+    void setBusRules(uint8_t program, uint8_t preview);
+
+    // "me1,me2,aux1" -> TallyBus bits; unknown names are skipped.
+    static uint8_t parseBusList(const String& list);
+
+    // True while the fast path has been heard from recently.
+    bool fastPathActive(uint32_t nowMs) const;
+
+    // True while a source other than MQTT owns program/preview.
+    bool directSourceActive(uint32_t nowMs) const;
+
     // Helpers
     bool isProgram(uint8_t input) const;
     bool isPreview(uint8_t input) const;
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Wall-clock time via the ESP-IDF SNTP client.
+//
+// Sync runs entirely in the lwIP task; a completion callback flags the
+// result and serviceTimeInit() picks it up from loop(). Nothing here ever
+// blocks the main loop. Time zones are applied with setenv("TZ")/tzset()
+// from a compiled-in IANA -> POSIX table, so no lookup server is needed.
+// The onboard RTC carries the time across reboots and power-off.
+
+// Seed the system clock from the BM8563 RTC and apply the time zone.
+// Call once in setup() after M5.begin() and config load; also schedules
+// the first SNTP sync (deferred when the RTC drift is known to be small).
+void time_setup();
+
+// Debounced time initialization API
+void requestTimeInit();
+void serviceTimeInit();
+
+// Optional: request a one-shot NTP resync via MQTT /cmd
+void requestTimeResync();
+
+// True once the system clock holds a plausible wall-clock time.
+bool time_isSet();
+
+// "Not Set" / "Syncing" / "RTC" / "Set" (setup screen)
+const char* time_statusName();
+
+// Local time as "h:mm:ss AM" (12-hour, no leading zero). Returns false
+// (and leaves out untouched) if the clock is not set yet.
+bool time_formatClock(char* out, size_t len);
+
+// Local time as ISO 8601 ("2025-01-31T14:05:09-0600").
+bool time_formatIso8601(char* out, size_t len);
+
+// Resolve an IANA zone name (or "GMT-6"-style offset, or a raw POSIX TZ
+// string) to the POSIX TZ string applied with setenv("TZ").
+const char* time_posixTzFor(const String& tz);
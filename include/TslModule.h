@@ -0,0 +1,26 @@
+#pragma once
+
+#include <M5Unified.h>
+#include "ConfigState.h"
+#include "TallyState.h"
+
+// TSL UMD tally listener (v3.1 and v5.0), UDP and TCP on tsl_port.
+//
+// Each display index maps to input (index + tsl_index_offset); only
+// inputs 1..63 are tracked. Tally lamps set program (red) / preview
+// (green), amber sets both; the brightness bits go to
+// AtemInputInfo::brightness and the text label to shortName. Receive and
+// parse use static buffers; a label is only reassigned when it changes.
+// While packets keep arriving (or a TCP sender is connected) TSL owns
+// program/preview and the MQTT tally topics are ignored.
+//
+// UDP: one v5.0 packet, or one or more 18-byte v3.1 messages, per
+// datagram. TCP: v5.0 with DLE/STX framing, or raw 18-byte v3.1 messages.
+
+// Open/close the listeners as Wi-Fi and config change, and apply whatever
+// arrived. Call from loop().
+void tsl_onLoop(const ConfigState& cfg, TallyState& tally);
+
+// Counters since boot
+uint32_t tsl_received();   // packets applied
+uint32_t tsl_rejected();   // malformed packets
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <M5Unified.h>
+#include "ConfigState.h"
+#include "TallyState.h"
+
+// Optional low-latency tally path: a fixed-format datagram on a UDP
+// multicast group, applied straight to TallyState. MQTT stays the source
+// of truth for labels and config; while datagrams keep arriving they own
+// program/preview, and MQTT takes over again once they stop.
+//
+// Datagram (12 bytes, multi-byte fields big-endian):
+//   0  'T' 'L'   magic
+//   2  version   UDP_TALLY_VERSION
+//   3  flags     reserved, 0
+//   4  seq       uint32, +1 per change; repeats of the current state
+//                (heartbeat) reuse the same seq
+//   8  program   input ID (0 = none)
+//   9  preview   input ID (0 = none)
+//  10  reserved  0, 0
+static constexpr uint8_t UDP_TALLY_VERSION   = 1;
+static constexpr size_t  UDP_TALLY_PACKET_LEN = 12;
+
+// Join/leave the configured group as Wi-Fi and config change, and apply
+// any datagrams that arrived. Call from loop().
+void udpTally_onLoop(const ConfigState& cfg, TallyState& tally);
+
+// Counters since boot
+uint32_t udpTally_received();   // applied to TallyState
+uint32_t udpTally_rejected();   // malformed or out of order (not while an ATEM session is up)
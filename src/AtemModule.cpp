@@ -0,0 +1,309 @@
+#include <WiFi.h>
+#include <lwip/sockets.h>
+
+#include "AtemModule.h"
+
+static const uint16_t ATEM_PORT          = 9910;
+static const uint32_t ATEM_HELLO_RETRY_MS = 1000;
+static const uint32_t ATEM_TIMEOUT_MS     = 3000;   // switcher pings several times a second
+static const uint8_t  ATEM_MAX_PER_LOOP   = 16;
+
+// Header: 5 flag bits + 11-bit length, session, ack id, resend-from id,
+// (unused), packet id. All big-endian.
+static const size_t  ATEM_HEADER_LEN      = 12;
+static const uint8_t FLAG_RELIABLE        = 0x01;
+static const uint8_t FLAG_HELLO           = 0x02;
+static const uint8_t FLAG_ACK             = 0x10;
+
+static const uint8_t HELLO_CONNECT        = 0x01;
+static const uint8_t HELLO_FULL           = 0x03;   // no free client slots
+
+static const uint16_t PACKET_ID_MASK      = 0x7FFF;
+
+static int       s_fd = -1;
+static String    s_address;            // atem_address the socket was opened for
+static AtemLink  s_link = AtemLink::Off;
+static uint16_t  s_session = 0;
+static uint16_t  s_lastRemoteId = 0;   // last in-order reliable packet
+static uint32_t  s_lastRxMs = 0;
+static uint32_t  s_lastHelloMs = 0;
+static bool      s_haveTlSr = false;   // prefer by-source tally once seen
+static uint32_t  s_resends = 0;
+
+// Header length field is 11 bits
+static uint8_t   s_rx[2048];
+
+static uint16_t be16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+static void sendPacket(const uint8_t* buf, size_t len) {
+    send(s_fd, buf, len, 0);   // best effort; the switcher resends
+}
+
+// Byte 9 values match what Blackmagic's own software sends
+static void sendHello() {
+    const uint8_t hello[20] = {
+        static_cast<uint8_t>(FLAG_HELLO << 3), 20,
+        0x53, 0xAB,                 // client-chosen session, replaced by the switcher's
+        0, 0, 0, 0, 0, 0x3A, 0, 0,
+        HELLO_CONNECT, 0, 0, 0, 0, 0, 0, 0
+    };
+    sendPacket(hello, sizeof(hello));
+    s_lastHelloMs = millis();
+}
+
+static void sendAck(uint16_t packetId) {
+    const uint8_t ack[ATEM_HEADER_LEN] = {
+        static_cast<uint8_t>(FLAG_ACK << 3), ATEM_HEADER_LEN,
+        static_cast<uint8_t>(s_session >> 8), static_cast<uint8_t>(s_session),
+        static_cast<uint8_t>(packetId >> 8),  static_cast<uint8_t>(packetId),
+        0, 0, 0, 0x41, 0, 0
+    };
+    sendPacket(ack, sizeof(ack));
+}
+
+static void closeSession(TallyState& tally) {
+    if (s_fd >= 0) {
+        close(s_fd);
+        s_fd = -1;
+    }
+    if (s_link != AtemLink::Off) {
+        Serial.println("[ATEM] session closed");
+    }
+    s_link = AtemLink::Off;
+    if (tally.atemDirect) {
+        tally.atemDirect = false;
+        tally.resetBuses();   // aux buses stop updating with the session
+    }
+}
+
+static bool openSocket(const String& address) {
+    IPAddress ip;
+    if (!ip.fromString(address)) {
+        return false;   // IP address only, no DNS
+    }
+
+    s_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s_fd < 0) {
+        return false;
+    }
+    fcntl(s_fd, F_SETFL, O_NONBLOCK);
+
+    sockaddr_in to = {};
+    to.sin_family      = AF_INET;
+    to.sin_port        = htons(ATEM_PORT);
+    to.sin_addr.s_addr = static_cast<uint32_t>(ip);
+    if (connect(s_fd, reinterpret_cast<sockaddr*>(&to), sizeof(to)) < 0) {
+        close(s_fd);
+        s_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+// --- Commands -------------------------------------------------
+
+// TlIn: u16 count, then one flag byte per tally index (bit 0 program,
+// bit 1 preview). Index n is input n for the external inputs.
+static void handleTlIn(const uint8_t* d, uint16_t len, TallyState& tally) {
+    if (s_haveTlSr || len < 2) return;
+    uint16_t count = be16(d);
+    if (count > len - 2) count = len - 2;
+
+    uint64_t program = 0, preview = 0;
+    for (uint16_t i = 0; i < count && i < 63; ++i) {
+        if (d[2 + i] & 0x01) program |= (1ULL << (i + 1));
+        if (d[2 + i] & 0x02) preview |= (1ULL << (i + 1));
+    }
+    tally.applySets(program, preview);
+}
+
+// TlSr: u16 count, then {u16 source, u8 flags} per source
+static void handleTlSr(const uint8_t* d, uint16_t len, TallyState& tally) {
+    if (len < 2) return;
+    uint16_t count = be16(d);
+    if (count > (len - 2) / 3) count = (len - 2) / 3;
+
+    uint64_t program = 0, preview = 0;
+    for (uint16_t i = 0; i < count; ++i) {
+        const uint8_t* e = d + 2 + i * 3;
+        uint16_t source = be16(e);
+        if (source == 0 || source >= 64) continue;   // black, bars, MPs, ...
+        if (e[2] & 0x01) program |= (1ULL << source);
+        if (e[2] & 0x02) preview |= (1ULL << source);
+    }
+    s_haveTlSr = true;
+    tally.applySets(program, preview);
+}
+
+// AuxS: u8 aux index, u8 unused, u16 source. Aux 1..3 feed the aux buses.
+static void handleAuxS(const uint8_t* d, uint16_t len, TallyState& tally) {
+    if (len < 4 || d[0] >= 3) return;
+    uint16_t source = be16(d + 2);
+    uint64_t program = (source > 0 && source < 64) ? (1ULL << source) : 0;
+    TallyBus bus = static_cast<TallyBus>(static_cast<uint8_t>(TallyBus::Aux1) + d[0]);
+    if (tally.busProgram[static_cast<uint8_t>(bus)] != program) {
+        tally.applySets(program, 0, bus);
+    }
+}
+
+// InPr: u16 id, char long[20], char short[4], ..., u8 internal port type
+// at 32 (0 = external input). Only external inputs carry tally.
+static bool handleInPr(const uint8_t* d, uint16_t len, TallyState& tally) {
+    if (len < 33) return false;
+    uint16_t id = be16(d);
+    if (id == 0 || id >= 64 || d[32] != 0) return false;
+
+    char longName[21];
+    char shortName[5];
+    memcpy(longName, d + 2, 20);
+    longName[20] = '\0';
+    memcpy(shortName, d + 22, 4);
+    shortName[4] = '\0';
+
+    auto it = tally.inputs.find(static_cast<uint8_t>(id));
+    if (it == tally.inputs.end()) {
+        AtemInputInfo info;
+        info.id           = static_cast<uint8_t>(id);
+        info.shortName    = shortName;
+        info.longName     = longName;
+        info.tallyEnabled = true;
+        tally.inputs[info.id] = info;
+        return true;
+    }
+    // Names only change when someone renames an input; don't reassign
+    // (and reallocate) on every session's state dump
+    bool changed = false;
+    if (it->second.shortName != shortName) { it->second.shortName = shortName; changed = true; }
+    if (it->second.longName  != longName)  { it->second.longName  = longName;  changed = true; }
+    return changed;
+}
+
+static void parseCommands(const uint8_t* p, size_t len, TallyState& tally) {
+    bool inputsChanged = false;
+
+    // Each command: u16 length (incl. this 8-byte header), u16 unused,
+    // char name[4], data
+    while (len >= 8) {
+        uint16_t clen = be16(p);
+        if (clen < 8 || clen > len) break;
+        const uint8_t* d    = p + 8;
+        const uint16_t dlen = clen - 8;
+
+        if (memcmp(p + 4, "TlSr", 4) == 0) {
+            handleTlSr(d, dlen, tally);
+        } else if (memcmp(p + 4, "TlIn", 4) == 0) {
+            handleTlIn(d, dlen, tally);
+        } else if (memcmp(p + 4, "AuxS", 4) == 0) {
+            handleAuxS(d, dlen, tally);
+        } else if (memcmp(p + 4, "InPr", 4) == 0) {
+            inputsChanged |= handleInPr(d, dlen, tally);
+        }
+        p   += clen;
+        len -= clen;
+    }
+
+    if (inputsChanged) {
+        tally.normalizeSelected();
+    }
+}
+
+// --- Packets --------------------------------------------------
+
+static void handlePacket(const uint8_t* buf, size_t len, TallyState& tally, uint32_t now) {
+    if (len < ATEM_HEADER_LEN) return;
+    const uint8_t  flags    = buf[0] >> 3;
+    const uint16_t plen     = be16(buf) & 0x07FF;
+    const uint16_t remoteId = be16(buf + 10);
+    if (plen != len) return;
+
+    if (flags & FLAG_HELLO) {
+        if (len > ATEM_HEADER_LEN && buf[ATEM_HEADER_LEN] == HELLO_FULL) {
+            Serial.println("[ATEM] switcher has no free sessions, retrying");
+            return;
+        }
+        s_link         = AtemLink::Up;
+        s_session      = be16(buf + 2);
+        s_lastRxMs     = now;
+        s_lastRemoteId = remoteId;
+        s_haveTlSr     = false;
+        tally.atemDirect = true;
+        tally.resetBuses();   // drop buses the combined topic left behind
+        sendAck(remoteId);
+        Serial.println("[ATEM] session up");
+        return;
+    }
+    if (s_link != AtemLink::Up) {
+        return;   // leftover from an old session
+    }
+    // The switcher moves to its own session ID right after the hello
+    s_session  = be16(buf + 2);
+    s_lastRxMs = now;
+
+    if (flags & FLAG_RELIABLE) {
+        const uint16_t expected = (s_lastRemoteId + 1) & PACKET_ID_MASK;
+        if (remoteId == expected) {
+            s_lastRemoteId = remoteId;
+            sendAck(remoteId);
+            parseCommands(buf + ATEM_HEADER_LEN, len - ATEM_HEADER_LEN, tally);
+        } else if (((s_lastRemoteId - remoteId) & PACKET_ID_MASK) < 0x4000) {
+            // Already have it (our ACK was lost): ACK again to stop resends
+            s_resends++;
+            sendAck(remoteId);
+        }
+        // Otherwise it is past a gap: drop it; the switcher resends the
+        // missing packet first and this one after it
+    }
+
+    // ACK and resend-request flags refer to our reliable packets, and a
+    // read-only client never sends any
+}
+
+void atem_onLoop(const ConfigState& cfg, TallyState& tally) {
+    const String& address = cfg.global.atemAddress;
+    if (address.length() == 0 || WiFi.status() != WL_CONNECTED) {
+        closeSession(tally);
+        return;
+    }
+
+    uint32_t now = millis();
+    if (s_fd < 0 || address != s_address) {
+        closeSession(tally);
+        if (!openSocket(address)) {
+            return;
+        }
+        s_address = address;
+        s_link    = AtemLink::Connecting;
+        Serial.printf("[ATEM] connecting to %s:%u\n", address.c_str(), (unsigned)ATEM_PORT);
+        sendHello();
+    }
+
+    for (uint8_t i = 0; i < ATEM_MAX_PER_LOOP; ++i) {
+        int n = recv(s_fd, s_rx, sizeof(s_rx), MSG_DONTWAIT);
+        if (n <= 0) break;
+        handlePacket(s_rx, static_cast<size_t>(n), tally, now);
+    }
+
+    if (s_link == AtemLink::Up && now - s_lastRxMs > ATEM_TIMEOUT_MS) {
+        Serial.println("[ATEM] switcher timed out, reconnecting");
+        s_link = AtemLink::Connecting;
+        tally.atemDirect = false;
+        tally.resetBuses();
+        sendHello();
+    } else if (s_link == AtemLink::Connecting && now - s_lastHelloMs > ATEM_HELLO_RETRY_MS) {
+        sendHello();
+    }
+}
+
+AtemLink atem_link() { return s_link; }
+
+const char* atem_linkName() {
+    switch (s_link) {
+        case AtemLink::Connecting: return "connecting";
+        case AtemLink::Up:         return "up";
+        default:                   return "off";
+    }
+}
+
+uint32_t atem_resends() { return s_resends; }
@@ -1,118 +1,175 @@
 #include "ButtonManager.h"
 
-#include <M5Unified.h>   // for M5.BtnA / BtnB
+#include <M5Unified.h>   // for M5.BtnPWR (PEK key state is read in M5.update())
+#include <esp_timer.h>
+#include <soc/gpio_reg.h>
+
+// M5StickC-Plus front (A) and side (B) buttons, active low
+static const int BTN_A_PIN = 37;
+static const int BTN_B_PIN = 39;
+
+// Per-pin ISR state. lastDown/lastUs are shared with reconcileLevels().
+struct ButtonPin {
+    ButtonID id;
+    int      pin;
+    bool     lastDown;
+    int64_t  lastUs;
+};
+
+static ButtonPin s_pins[] = {
+    { ButtonID::A, BTN_A_PIN, false, 0 },
+    { ButtonID::B, BTN_B_PIN, false, 0 },
+};
+
+static ButtonManager* s_manager = nullptr;
+static portMUX_TYPE   s_pinMux  = portMUX_INITIALIZER_UNLOCKED;
+
+// gpio_get_level() lives in flash; read the input register directly
+static ISR_INLINE bool pinIsLow(int pin) {
+    const uint32_t in = (pin < 32) ? REG_READ(GPIO_IN_REG) : REG_READ(GPIO_IN1_REG);
+    return ((in >> (pin & 31)) & 1) == 0;
+}
+
+// Edge capture: timestamp, debounce in the ISR time domain, queue.
+// Re-reading the level also filters the spurious interrupts GPIO39 is
+// known to get while Wi-Fi is active (level unchanged -> ignored).
+// Everything called from here is in IRAM or inlined (ISR_INLINE).
+static void IRAM_ATTR onButtonEdge(void* arg) {
+    ButtonPin* p = static_cast<ButtonPin*>(arg);
+    const int64_t nowUs = esp_timer_get_time();
+    const bool down = pinIsLow(p->pin);
+
+    portENTER_CRITICAL_ISR(&s_pinMux);
+    bool accept = debounceEdge(down, nowUs, p->lastDown, p->lastUs);
+    portEXIT_CRITICAL_ISR(&s_pinMux);
+
+    if (accept && s_manager) {
+        ButtonEdge e;
+        e.id   = p->id;
+        e.down = down;
+        e.atMs = static_cast<uint32_t>(nowUs / 1000);
+        s_manager->pushEdge(e);
+    }
+}
 
-void ButtonManager::begin(uint32_t longPressMs) {
+void ButtonManager::begin(uint32_t longPressMs, uint32_t doubleClickMs) {
     _longPressMs = longPressMs;
-    _aWasDown    = false;
-    _bWasDown    = false;
-    _aDownAtMs   = 0;
-    _bDownAtMs   = 0;
-    _aLongPressFired = false;
-    _bLongPressFired = false;
+    _a.configure(longPressMs, doubleClickMs);
+    _b.configure(longPressMs, doubleClickMs);
+    _pwr.configure(longPressMs, doubleClickMs);
+
+    s_manager = this;
+    for (auto& p : s_pins) {
+        pinMode(p.pin, INPUT);
+        p.lastDown = (digitalRead(p.pin) == LOW);
+        p.lastUs   = esp_timer_get_time();
+        attachInterruptArg(digitalPinToInterrupt(p.pin), onButtonEdge, &p, CHANGE);
+    }
 }
 
 ButtonEvent ButtonManager::poll() {
-    ButtonEvent ev;  // defaults to "no event"
-
     const uint32_t now = millis();
 
-    // Read current button states
-    const bool aDown = M5.BtnA.isPressed();
-    const bool bDown = M5.BtnB.isPressed();
-
-    // Handle A then B; if A produced an event, we can return immediately.
-    ev = handleButtonA(aDown, now);
-    if (ev.type != ButtonType::None) {
-        return ev;
+    // 1) Apply every captured edge with its ISR timestamp
+    ButtonEdge e;
+    while (_edges.pop(e)) {
+        handleEdge(e);
     }
 
-    ev = handleButtonB(bDown, now);
+    // 2) Catch a release the debounce window swallowed (very short taps)
+    reconcileLevels(now);
+
+    // 3) PEK key (AXP192 reports it after the fact; synthesize edges)
+    pollPowerKey(now);
+
+    // 4) Time-based decisions: long press while held, double-click timeout
+    ButtonType t;
+    if ((t = _a.tick(now))   != ButtonType::None) emit(ButtonID::A, t, now);
+    if ((t = _b.tick(now))   != ButtonType::None) emit(ButtonID::B, t, now);
+    if ((t = _pwr.tick(now)) != ButtonType::None) emit(ButtonID::Power, t, now);
+
+    ButtonEvent ev;  // defaults to "no event"
+    _events.pop(ev);
     return ev;
 }
 
-ButtonEvent ButtonManager::handleButtonA(bool isDown, uint32_t nowMs) {
-    ButtonEvent ev;
-
-    if (isDown && !_aWasDown) {
-        // Just pressed
-        _aWasDown        = true;
-        _aDownAtMs       = nowMs;
-        _aLongPressFired = false;
-    }
-    else if (isDown && _aWasDown) {
-        // Held down: check for long-press threshold
-        const uint32_t held = nowMs - _aDownAtMs;
-        if (!_aLongPressFired && held >= _longPressMs) {
-            _aLongPressFired = true;
-            ev.id   = ButtonID::A;
-            ev.type = ButtonType::LongPress;
-            return ev;  // fire immediately while still held
-        }
+void ButtonManager::handleEdge(const ButtonEdge& e) {
+    ButtonType t = ButtonType::None;
+
+    switch (e.id) {
+        case ButtonID::A:
+            t = _a.onEdge(e.down, e.atMs);
+            // B held and undecided when A goes down -> chord
+            if (e.down && _b.isPending()) {
+                emit(ButtonID::B, ButtonType::Chord, e.atMs, ButtonID::A);
+                _a.suppress();
+                _b.suppress();
+                return;
+            }
+            break;
+
+        case ButtonID::B:
+            t = _b.onEdge(e.down, e.atMs);
+            if (e.down && _a.isPending()) {
+                emit(ButtonID::A, ButtonType::Chord, e.atMs, ButtonID::B);
+                _a.suppress();
+                _b.suppress();
+                return;
+            }
+            break;
+
+        case ButtonID::Power:
+            t = _pwr.onEdge(e.down, e.atMs);
+            break;
+
+        case ButtonID::None:
+        default:
+            return;
     }
-    else if (!isDown && _aWasDown) {
-        // Just released
-        _aWasDown = false;
-
-        // If a long-press already fired, do not emit a short-press
-        if (_aLongPressFired) {
-            _aLongPressFired = false;
-            return ev;  // ev.type remains None
-        }
 
-        // Otherwise treat this as a press based on duration
-        const uint32_t held = nowMs - _aDownAtMs;
-        ev.id = ButtonID::A;
-        if (held >= _longPressMs) {
-            // Edge case: threshold crossed but we didn't catch it in the held branch
-            ev.type = ButtonType::LongPress;
-        } else {
-            ev.type = ButtonType::ShortPress;
-        }
+    if (t != ButtonType::None) {
+        emit(e.id, t, e.atMs);
     }
-
-    return ev;
 }
 
-ButtonEvent ButtonManager::handleButtonB(bool isDown, uint32_t nowMs) {
-    ButtonEvent ev;
+void ButtonManager::reconcileLevels(uint32_t nowMs) {
+    const int64_t nowUs = esp_timer_get_time();
 
-    if (isDown && !_bWasDown) {
-        // Just pressed
-        _bWasDown        = true;
-        _bDownAtMs       = nowMs;
-        _bLongPressFired = false;
-    }
-    else if (isDown && _bWasDown) {
-        // Held down: check for long-press threshold
-        const uint32_t held = nowMs - _bDownAtMs;
-        if (!_bLongPressFired && held >= _longPressMs) {
-            _bLongPressFired = true;
-            ev.id   = ButtonID::B;
-            ev.type = ButtonType::LongPress;
-            return ev;  // fire immediately while still held
+    for (auto& p : s_pins) {
+        const bool down = (digitalRead(p.pin) == LOW);
+
+        portENTER_CRITICAL(&s_pinMux);
+        bool stale = debounceEdge(down, nowUs, p.lastDown, p.lastUs);
+        portEXIT_CRITICAL(&s_pinMux);
+
+        if (stale) {
+            ButtonEdge e;
+            e.id   = p.id;
+            e.down = down;
+            e.atMs = nowMs;
+            handleEdge(e);
         }
     }
-    else if (!isDown && _bWasDown) {
-        // Just released
-        _bWasDown = false;
-
-        // If a long-press already fired, do not emit a short-press
-        if (_bLongPressFired) {
-            _bLongPressFired = false;
-            return ev;  // ev.type remains None
-        }
+}
 
-        // Otherwise treat this as a press based on duration
-        const uint32_t held = nowMs - _bDownAtMs;
-        ev.id = ButtonID::B;
-        if (held >= _longPressMs) {
-            // Edge case: threshold crossed but we didn't catch it in the held branch
-            ev.type = ButtonType::LongPress;
-        } else {
-            ev.type = ButtonType::ShortPress;
-        }
+void ButtonManager::pollPowerKey(uint32_t nowMs) {
+    ButtonEdge e;
+    e.id = ButtonID::Power;
+
+    if (M5.BtnPWR.wasClicked()) {
+        e.down = true;  e.atMs = nowMs - 1;            handleEdge(e);
+        e.down = false; e.atMs = nowMs;                handleEdge(e);
+    } else if (M5.BtnPWR.wasHold()) {
+        e.down = true;  e.atMs = nowMs - _longPressMs; handleEdge(e);
+        e.down = false; e.atMs = nowMs;                handleEdge(e);
     }
+}
 
-    return ev;
-}
\ No newline at end of file
+void ButtonManager::emit(ButtonID id, ButtonType type, uint32_t atMs, ButtonID other) {
+    ButtonEvent ev;
+    ev.id    = id;
+    ev.type  = type;
+    ev.other = other;
+    ev.atMs  = atMs;
+    _events.push(ev);
+}
@@ -22,6 +22,13 @@ void ButtonRouter::handle(const ButtonEvent& ev) {
         return;
     }
 
+    // Chords are reported on the first button held; either order works
+    if (ev.type == ButtonType::Chord) {
+        Serial.println("BtnA+BtnB chord -> changeScreen(SCREEN_TALLY)");
+        changeScreen(SCREEN_TALLY);
+        return;
+    }
+
     switch (ev.id) {
         case ButtonID::A:
             if (ev.type == ButtonType::ShortPress) {
@@ -61,6 +68,10 @@ void ButtonRouter::handle(const ButtonEvent& ev) {
             }
             break;
 
+        case ButtonID::Power:
+            // (PEK key currently unused; the AXP192 still powers off on a 6 s hold.)
+            break;
+
         case ButtonID::None:
         default:
             break;
@@ -0,0 +1,261 @@
+#include "ConfigSchema.h"
+
+// Address of a ConfigState field, as a plain function so the table stays
+// a constant expression (one instantiation per row)
+template <typename S, S ConfigState::*Scope, typename T, T S::*Member>
+static void* configField(ConfigState& cfg) {
+    return &(cfg.*Scope.*Member);
+}
+
+#define CFG_FIELD_Global(m) GlobalConfig, &ConfigState::global, decltype(GlobalConfig::m), &GlobalConfig::m
+#define CFG_FIELD_Device(m) DeviceConfig, &ConfigState::device, decltype(DeviceConfig::m), &DeviceConfig::m
+#define CFG_TYPE_Global(m)  ConfigTypeOf<decltype(GlobalConfig::m)>::value
+#define CFG_TYPE_Device(m)  ConfigTypeOf<decltype(DeviceConfig::m)>::value
+
+#define CFG_KEY(scope, name, member, range, lo, hi, def, defText, names, flags) \
+    { name, configKeyHash(name), ConfigScope::scope, CFG_TYPE_##scope(member),  \
+      ConfigRange::range, lo, hi, def, defText, names, flags,                   \
+      &configField<CFG_FIELD_##scope(member)> }
+
+#define STR_KEY(scope, name, member, def, flags) \
+    CFG_KEY(scope, name, member, Reject, 0, 0, 0, def, nullptr, flags)
+#define INT_KEY(scope, name, member, range, lo, hi, def, flags) \
+    CFG_KEY(scope, name, member, range, lo, hi, def, nullptr, nullptr, flags)
+#define BOOL_KEY(scope, name, member, def, flags) \
+    CFG_KEY(scope, name, member, Reject, 0, 1, def, nullptr, nullptr, flags)
+#define ENUM_KEY(scope, name, member, names, def, flags) \
+    CFG_KEY(scope, name, member, Reject, 0, 0, static_cast<int32_t>(def), nullptr, names, flags)
+
+// Indexed by enum value
+static constexpr const char* WIFI_SLEEP_NAMES[]      = { "none", "modem", "light", nullptr };
+static constexpr const char* STATUS_ENCODING_NAMES[] = { "topics", "json", "msgpack", nullptr };
+static constexpr const char* LOG_LEVEL_NAMES[]       = { "none", "error", "warn", "info", "debug", nullptr };
+
+namespace D = ConfigDefaults;
+
+static constexpr ConfigKeyDesc CONFIG_KEYS[] = {
+    // Network / infrastructure (mqtt_* are persisted by the WiFiManager portal)
+    STR_KEY (Global, "mqtt_server",   mqttServer,   D::MQTT_SERVER,   CFG_RESTART),
+    INT_KEY (Global, "mqtt_port",     mqttPort,     Reject, 1, 65535, D::MQTT_PORT, CFG_RESTART),
+    STR_KEY (Global, "mqtt_username", mqttUsername, D::MQTT_USERNAME, CFG_RESTART),
+    STR_KEY (Global, "mqtt_password", mqttPassword, D::MQTT_PASSWORD, CFG_RESTART | CFG_SECRET),
+    STR_KEY (Global, "ntp_server",    ntpServer,    D::NTP_SERVER_DEFAULT, CFG_PERSIST | CFG_TIME),
+    STR_KEY (Global, "timezone",      timeZone,     D::TIMEZONE,      CFG_PERSIST | CFG_TIME),
+    INT_KEY (Global, "reconnect_window", reconnectWindowSec, Clamp, 0, 600, D::RECONNECT_WINDOW_SEC, CFG_PERSIST),
+    INT_KEY (Global, "publish_rate",  publishRatePerSec, Clamp, 1, 100, D::PUBLISH_RATE_PER_SEC, CFG_PERSIST),
+    STR_KEY (Global, "atem_address",  atemAddress,  D::ATEM_ADDRESS,  CFG_PERSIST),
+    INT_KEY (Global, "tsl_port",      tslPort,      Reject, 0, 65535, D::TSL_PORT, CFG_PERSIST),
+    INT_KEY (Global, "tsl_index_offset", tslIndexOffset, Clamp, -127, 127, D::TSL_INDEX_OFFSET, CFG_PERSIST),
+    STR_KEY (Global, "udp_tally_group", udpTallyGroup, D::UDP_TALLY_GROUP, CFG_PERSIST),
+    INT_KEY (Global, "udp_tally_port", udpTallyPort, Reject, 1, 65535, D::UDP_TALLY_PORT, CFG_PERSIST),
+
+    // Display / tally
+    INT_KEY (Global, "brightness",    brightness,   Reject, 0, 100, D::BRIGHTNESS, CFG_PERSIST),
+    INT_KEY (Global, "powersaver_brightness",  powersaverBrightness, Reject, 0, 100, D::POWERSAVER_BRIGHTNESS, CFG_PERSIST),
+    INT_KEY (Global, "powersaver_battery_pct", powersaverBatteryPct, Reject, 0, 100, D::POWERSAVER_BATTERY_PCT, CFG_PERSIST),
+    STR_KEY (Global, "tally_color_program", tallyColorProgram, D::TALLY_COLOR_PROGRAM, CFG_PERSIST),
+    STR_KEY (Global, "tally_color_preview", tallyColorPreview, D::TALLY_COLOR_PREVIEW, CFG_PERSIST),
+    STR_KEY (Global, "tally_program_buses", tallyProgramBuses, D::TALLY_PROGRAM_BUSES, CFG_PERSIST | CFG_BUS_RULES),
+    STR_KEY (Global, "tally_preview_buses", tallyPreviewBuses, D::TALLY_PREVIEW_BUSES, CFG_PERSIST | CFG_BUS_RULES),
+    INT_KEY (Global, "tally_coalesce_ms", tallyCoalesceMs, Clamp, 0, 30, D::TALLY_COALESCE_MS, CFG_PERSIST),
+
+    // Wi-Fi tuning / status
+    INT_KEY (Global, "wifi_tx_power", wifiTxPowerDbm, Clamp, 2, 20, D::WIFI_TX_POWER_DBM, CFG_PERSIST | CFG_RESTART),
+    ENUM_KEY(Global, "wifi_sleep",    wifiSleep,    WIFI_SLEEP_NAMES, D::WIFI_SLEEP, CFG_PERSIST | CFG_RESTART),
+    INT_KEY (Global, "status_interval", statusIntervalSec, Default, 1, 65535, D::STATUS_INTERVAL_SEC, CFG_PERSIST),
+    ENUM_KEY(Global, "status_encoding", statusEncoding, STATUS_ENCODING_NAMES, D::STATUS_ENCODING, CFG_PERSIST),
+    BOOL_KEY(Global, "config_echo",   configEcho,   D::CONFIG_ECHO,   CFG_PERSIST),
+    INT_KEY (Global, "idle_dim_seconds", idleDimSeconds, Clamp, 0, 65535, D::IDLE_DIM_SECONDS, CFG_PERSIST),
+
+    // Per-device (name and input are restored by the warm-start tally cache)
+    STR_KEY (Device, "name",          friendlyName, D::FRIENDLY_NAME, 0),
+    INT_KEY (Device, "input",         atemInput,    Reject, 0, 255, D::ATEAM_INPUT_DEFAULT, CFG_INPUT),
+    INT_KEY (Device, "battery_capacity", batteryCapacityMah, Reject, 1, 65535, D::BATTERY_CAPACITY_MAH, CFG_PERSIST),
+    INT_KEY (Device, "idle_dim_seconds", idleDimSecondsOverride, Clamp, 0, 65535, 0xFFFF, CFG_PERSIST),
+    ENUM_KEY(Device, "log_level",     logLevel,     LOG_LEVEL_NAMES,  D::LOG_LEVEL, CFG_PERSIST),
+};
+
+static constexpr size_t CONFIG_KEY_COUNT = sizeof(CONFIG_KEYS) / sizeof(CONFIG_KEYS[0]);
+
+// Open-addressed index over CONFIG_KEYS, built on first use
+static constexpr size_t  CONFIG_INDEX_SIZE  = 64;   // power of two, > 1.5x the table
+static constexpr uint8_t CONFIG_INDEX_EMPTY = 0xFF;
+static_assert(CONFIG_KEY_COUNT * 3 / 2 < CONFIG_INDEX_SIZE, "grow CONFIG_INDEX_SIZE");
+
+static uint8_t s_index[CONFIG_INDEX_SIZE];
+static bool    s_indexBuilt = false;
+
+// Same key name in both scopes (idle_dim_seconds) lands in different slots
+static uint32_t indexHash(ConfigScope scope, uint32_t hash) {
+    return scope == ConfigScope::Device ? hash ^ 0x9E3779B9u : hash;
+}
+
+static void buildIndex() {
+    memset(s_index, CONFIG_INDEX_EMPTY, sizeof(s_index));
+    for (size_t i = 0; i < CONFIG_KEY_COUNT; ++i) {
+        uint32_t slot = indexHash(CONFIG_KEYS[i].scope, CONFIG_KEYS[i].hash);
+        while (s_index[slot & (CONFIG_INDEX_SIZE - 1)] != CONFIG_INDEX_EMPTY) {
+            slot++;
+        }
+        s_index[slot & (CONFIG_INDEX_SIZE - 1)] = static_cast<uint8_t>(i);
+    }
+    s_indexBuilt = true;
+}
+
+const ConfigKeyDesc* configSchema_table(size_t& count) {
+    count = CONFIG_KEY_COUNT;
+    return CONFIG_KEYS;
+}
+
+const ConfigKeyDesc* configSchema_find(ConfigScope scope, const String& key) {
+    if (!s_indexBuilt) {
+        buildIndex();
+    }
+    const uint32_t hash = configKeyHash(key.c_str());
+    uint32_t slot = indexHash(scope, hash);
+    for (;;) {
+        uint8_t i = s_index[slot & (CONFIG_INDEX_SIZE - 1)];
+        if (i == CONFIG_INDEX_EMPTY) {
+            return nullptr;
+        }
+        const ConfigKeyDesc& d = CONFIG_KEYS[i];
+        if (d.hash == hash && d.scope == scope && key == d.name) {
+            return &d;
+        }
+        slot++;
+    }
+}
+
+static int32_t readInt(const ConfigKeyDesc& d, const void* p) {
+    switch (d.type) {
+        case ConfigType::Bool: return *static_cast<const bool*>(p) ? 1 : 0;
+        case ConfigType::U8:
+        case ConfigType::Enum: return *static_cast<const uint8_t*>(p);
+        case ConfigType::U16:  return *static_cast<const uint16_t*>(p);
+        case ConfigType::I8:   return *static_cast<const int8_t*>(p);
+        case ConfigType::I16:  return *static_cast<const int16_t*>(p);
+        default:               return 0;
+    }
+}
+
+static void writeInt(const ConfigKeyDesc& d, void* p, int32_t v) {
+    switch (d.type) {
+        case ConfigType::Bool: *static_cast<bool*>(p)     = v != 0; break;
+        case ConfigType::U8:
+        case ConfigType::Enum: *static_cast<uint8_t*>(p)  = static_cast<uint8_t>(v); break;
+        case ConfigType::U16:  *static_cast<uint16_t*>(p) = static_cast<uint16_t>(v); break;
+        case ConfigType::I8:   *static_cast<int8_t*>(p)   = static_cast<int8_t>(v); break;
+        case ConfigType::I16:  *static_cast<int16_t*>(p)  = static_cast<int16_t>(v); break;
+        default: break;
+    }
+}
+
+// Text -> value for the non-string types. False if it can't be used.
+static bool parseValue(const ConfigKeyDesc& d, const String& text, int32_t& v) {
+    if (text.length() == 0) {
+        v = d.def;
+        return true;
+    }
+
+    if (d.type == ConfigType::Enum) {
+        v = d.def;   // unknown names fall back to the default
+        for (int32_t i = 0; d.names[i] != nullptr; ++i) {
+            if (text.equalsIgnoreCase(d.names[i])) {
+                v = i;
+                break;
+            }
+        }
+        return true;
+    }
+
+    if (d.type == ConfigType::Bool) {
+        if (text == "1" || text.equalsIgnoreCase("true") || text.equalsIgnoreCase("on")) {
+            v = 1;
+        } else if (text == "0" || text.equalsIgnoreCase("false") || text.equalsIgnoreCase("off")) {
+            v = 0;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    long raw = text.toInt();
+    if (raw < d.min || raw > d.max) {
+        switch (d.range) {
+            case ConfigRange::Clamp:   raw = raw < d.min ? d.min : d.max; break;
+            case ConfigRange::Reject:  return false;
+            case ConfigRange::Default: raw = d.def; break;
+        }
+    }
+    v = static_cast<int32_t>(raw);
+    return true;
+}
+
+ConfigApplyResult configSchema_set(ConfigState& cfg, const ConfigKeyDesc& d, const String& text) {
+    ConfigApplyResult r;
+    r.desc = &d;
+    void* field = d.field(cfg);
+
+    if (d.type == ConfigType::Str) {
+        String& s = *static_cast<String*>(field);
+        const char* v = text.length() ? text.c_str() : d.defText;
+        r.accepted = true;
+        r.changed  = s != v;
+        if (r.changed) s = v;
+        return r;
+    }
+
+    int32_t v;
+    if (!parseValue(d, text, v)) {
+        return r;
+    }
+    r.accepted = true;
+    r.changed  = readInt(d, field) != v;
+    writeInt(d, field, v);
+    return r;
+}
+
+ConfigApplyResult configSchema_apply(ConfigState& cfg, ConfigScope scope,
+                                     const String& key, const String& payload) {
+    const ConfigKeyDesc* d = configSchema_find(scope, key);
+    if (!d) {
+        return ConfigApplyResult();
+    }
+    return configSchema_set(cfg, *d, payload);
+}
+
+String configSchema_format(const ConfigState& cfg, const ConfigKeyDesc& d) {
+    const void* field = d.field(const_cast<ConfigState&>(cfg));
+    switch (d.type) {
+        case ConfigType::Str:
+            return *static_cast<const String*>(field);
+        case ConfigType::Bool:
+            return readInt(d, field) ? "true" : "false";
+        case ConfigType::Enum:
+            return d.names[readInt(d, field)];
+        default:
+            return String(readInt(d, field));
+    }
+}
+
+String configSchema_echo(const ConfigState& cfg) {
+    JsonDocument doc;
+    JsonObject scopes[2] = { doc["global"].to<JsonObject>(), doc["device"].to<JsonObject>() };
+
+    for (const ConfigKeyDesc& d : CONFIG_KEYS) {
+        if (d.flags & CFG_SECRET) continue;
+        JsonObject obj = scopes[d.scope == ConfigScope::Device ? 1 : 0];
+        const void* field = d.field(const_cast<ConfigState&>(cfg));
+
+        switch (d.type) {
+            case ConfigType::Str:  obj[d.name] = *static_cast<const String*>(field); break;
+            case ConfigType::Bool: obj[d.name] = readInt(d, field) != 0; break;
+            case ConfigType::Enum: obj[d.name] = d.names[readInt(d, field)]; break;
+            default:               obj[d.name] = readInt(d, field); break;
+        }
+    }
+
+    String out;
+    serializeJson(doc, out);
+    return out;
+}
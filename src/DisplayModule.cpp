@@ -2,6 +2,8 @@
 #include "DisplayModule.h"
 #include "ScreenModule.h"  // for currentBrightness and setBrightness
 
+DisplayFrameStats displayStats;
+
 void cycleBrightness() {
     // Discrete brightness levels we cycle through
     static const int levels[] = {20, 30, 40, 50, 60, 70, 80, 90, 100};
@@ -20,4 +22,20 @@ void cycleBrightness() {
 
     currentBrightness = levels[idx];
     setBrightness(currentBrightness);
-}
\ No newline at end of file
+}
+
+
+// --- Display push timing ---------------------------------------
+
+void display_push(LGFX_Sprite& sprite, int32_t x, int32_t y) {
+    uint32_t t0 = micros();
+    sprite.pushSprite(&M5.Display, x, y);
+    uint32_t blocked = micros() - t0;
+
+    displayStats.frames++;
+    displayStats.lastBlockedUs   = blocked;
+    displayStats.totalBlockedUs += blocked;
+    if (blocked > displayStats.maxBlockedUs) {
+        displayStats.maxBlockedUs = blocked;
+    }
+}
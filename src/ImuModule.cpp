@@ -0,0 +1,201 @@
+#include <M5Unified.h>
+#include "Wire.h"
+
+#include "ImuModule.h"
+
+// Enable IMU debugging logs
+//#define DEBUG_IMU
+
+// MPU6886 on the internal I2C bus; INT is wired to G35 on the StickC-Plus
+static const uint8_t  MPU6886_ADDR = 0x68;
+static const int      IMU_INT_PIN  = 35;
+
+// MPU6886 registers
+static const uint8_t REG_SMPLRT_DIV       = 0x19;
+static const uint8_t REG_ACCEL_CONFIG     = 0x1C;
+static const uint8_t REG_ACCEL_CONFIG2    = 0x1D;
+static const uint8_t REG_ACCEL_WOM_X_THR  = 0x20;
+static const uint8_t REG_ACCEL_WOM_Y_THR  = 0x21;
+static const uint8_t REG_ACCEL_WOM_Z_THR  = 0x22;
+static const uint8_t REG_FIFO_EN          = 0x23;
+static const uint8_t REG_INT_PIN_CFG      = 0x37;
+static const uint8_t REG_INT_ENABLE       = 0x38;
+static const uint8_t REG_INT_STATUS       = 0x3A;
+static const uint8_t REG_ACCEL_XOUT_H     = 0x3B;
+static const uint8_t REG_ACCEL_INTEL_CTRL = 0x69;
+static const uint8_t REG_USER_CTRL        = 0x6A;
+static const uint8_t REG_PWR_MGMT_2       = 0x6C;
+static const uint8_t REG_FIFO_COUNTH      = 0x72;
+static const uint8_t REG_FIFO_R_W         = 0x74;
+
+// Wake-on-motion threshold, 4 mg per LSB. WOM compares each sample with
+// the previous one (10 ms apart at 100 Hz), so this is a per-sample step,
+// not a total change: a 90 degree turn over ~1.3 s moves ~12 mg per sample.
+// Still well above the accelerometer noise (~2 mg rms at this bandwidth).
+static const uint8_t  WOM_THRESHOLD_LSB = 12 / 4;
+
+// FIFO burst: 100 Hz sample rate, collect ~50 ms after the interrupt
+static const uint8_t  SAMPLE_RATE_DIV   = 9;     // 1 kHz / (1 + 9) = 100 Hz
+static const uint32_t BURST_MS          = 50;
+static const size_t   FIFO_SAMPLE_BYTES = 6;     // accel X/Y/Z only
+static const size_t   FIFO_MAX_SAMPLES  = 16;
+
+// Don't re-arm faster than this while the rig is being handled
+static const uint32_t MIN_EVENT_INTERVAL_MS = 100;
+
+// The burst is taken while the device is still moving; read once more
+// when no motion event has fired for this long, so the final resting
+// orientation wins
+static const uint32_t SETTLE_MS = 300;
+
+static volatile bool s_motionIrq = false;
+static bool          s_collecting = false;
+static uint32_t      s_burstStartMs = 0;
+static uint32_t      s_lastEventMs = 0;
+static bool          s_settlePending = false;
+static float         s_lsbPerG = 4096.0f;  // updated from ACCEL_CONFIG
+
+// --- MPU6886 register helpers ------------------------------------------------
+
+static void imuWrite1Byte(uint8_t Addr, uint8_t Data) {
+    Wire1.beginTransmission(MPU6886_ADDR);
+    Wire1.write(Addr);
+    Wire1.write(Data);
+    Wire1.endTransmission();
+}
+
+static uint8_t imuRead8bit(uint8_t Addr) {
+    Wire1.beginTransmission(MPU6886_ADDR);
+    Wire1.write(Addr);
+    Wire1.endTransmission();
+    Wire1.requestFrom(MPU6886_ADDR, (uint8_t)1);
+    return Wire1.read();
+}
+
+static size_t imuReadBytes(uint8_t Addr, uint8_t* buf, size_t len) {
+    Wire1.beginTransmission(MPU6886_ADDR);
+    Wire1.write(Addr);
+    Wire1.endTransmission();
+    size_t got = Wire1.requestFrom(MPU6886_ADDR, (uint8_t)len);
+    for (size_t i = 0; i < got; i++) {
+        buf[i] = Wire1.read();
+    }
+    return got;
+}
+
+static void decodeAccel(const uint8_t* raw, float& ax, float& ay, float& az) {
+    ax = (int16_t)((raw[0] << 8) | raw[1]) / s_lsbPerG;
+    ay = (int16_t)((raw[2] << 8) | raw[3]) / s_lsbPerG;
+    az = (int16_t)((raw[4] << 8) | raw[5]) / s_lsbPerG;
+}
+
+// ---------------------------------------------------------------------------
+
+static void IRAM_ATTR onImuInterrupt() {
+    s_motionIrq = true;
+}
+
+void imu_setup() {
+    // Keep whatever full-scale range M5Unified chose, just track it
+    uint8_t fs = (imuRead8bit(REG_ACCEL_CONFIG) >> 3) & 0x03;
+    s_lsbPerG = 16384.0f / (1 << fs);
+
+    imuWrite1Byte(REG_PWR_MGMT_2, 0x07);        // accel on, gyro off
+    imuWrite1Byte(REG_ACCEL_CONFIG2, 0x01);     // DLPF 218 Hz, enables SMPLRT_DIV
+    imuWrite1Byte(REG_SMPLRT_DIV, SAMPLE_RATE_DIV);
+
+    imuWrite1Byte(REG_ACCEL_WOM_X_THR, WOM_THRESHOLD_LSB);
+    imuWrite1Byte(REG_ACCEL_WOM_Y_THR, WOM_THRESHOLD_LSB);
+    imuWrite1Byte(REG_ACCEL_WOM_Z_THR, WOM_THRESHOLD_LSB);
+    // WOM on, compare with the previous sample (the only defined mode)
+    imuWrite1Byte(REG_ACCEL_INTEL_CTRL, 0xC0);
+
+    // INT active high, push-pull, latched until INT_STATUS is read
+    imuWrite1Byte(REG_INT_PIN_CFG, 0x20);
+    imuWrite1Byte(REG_INT_ENABLE, 0xE0);        // WOM X/Y/Z
+
+    // FIFO stays off until a motion event needs a burst
+    imuWrite1Byte(REG_FIFO_EN, 0x00);
+    imuWrite1Byte(REG_USER_CTRL, 0x04);         // FIFO reset
+    imuRead8bit(REG_INT_STATUS);                // clear any stale latch
+
+    pinMode(IMU_INT_PIN, INPUT);
+    attachInterrupt(digitalPinToInterrupt(IMU_INT_PIN), onImuInterrupt, RISING);
+}
+
+bool imu_readAccelNow(float& ax, float& ay, float& az) {
+    uint8_t raw[FIFO_SAMPLE_BYTES];
+    if (imuReadBytes(REG_ACCEL_XOUT_H, raw, sizeof(raw)) != sizeof(raw)) {
+        return false;
+    }
+    decodeAccel(raw, ax, ay, az);
+    return true;
+}
+
+bool imu_takeMotionSample(float& ax, float& ay, float& az) {
+    uint32_t now = millis();
+
+    if (!s_collecting) {
+        if (!s_motionIrq) {
+            if (s_settlePending && now - s_lastEventMs >= SETTLE_MS) {
+                s_settlePending = false;
+                return imu_readAccelNow(ax, ay, az);   // at rest now
+            }
+            return false;   // still: no I2C traffic at all
+        }
+        if (now - s_lastEventMs < MIN_EVENT_INTERVAL_MS) {
+            return false;   // leave the latch set; handle it shortly
+        }
+        s_motionIrq = false;
+        s_lastEventMs = now;
+        s_settlePending = true;
+        imuRead8bit(REG_INT_STATUS);            // clear latch so the next motion re-fires
+
+        // Start a fresh FIFO burst
+        imuWrite1Byte(REG_USER_CTRL, 0x04);     // FIFO reset
+        imuWrite1Byte(REG_USER_CTRL, 0x40);     // FIFO enable
+        imuWrite1Byte(REG_FIFO_EN, 0x08);       // accel into FIFO
+        s_collecting   = true;
+        s_burstStartMs = now;
+        return false;
+    }
+
+    if (now - s_burstStartMs < BURST_MS) {
+        return false;
+    }
+    s_collecting = false;
+
+    uint8_t cnt[2];
+    imuReadBytes(REG_FIFO_COUNTH, cnt, sizeof(cnt));
+    size_t samples = (((cnt[0] & 0x1F) << 8) | cnt[1]) / FIFO_SAMPLE_BYTES;
+    if (samples > FIFO_MAX_SAMPLES) samples = FIFO_MAX_SAMPLES;
+
+    float sx = 0.0f, sy = 0.0f, sz = 0.0f;
+    size_t used = 0;
+    uint8_t raw[FIFO_SAMPLE_BYTES];
+    for (size_t i = 0; i < samples; i++) {
+        if (imuReadBytes(REG_FIFO_R_W, raw, sizeof(raw)) != sizeof(raw)) break;
+        float x, y, z;
+        decodeAccel(raw, x, y, z);
+        sx += x; sy += y; sz += z;
+        used++;
+    }
+
+    imuWrite1Byte(REG_FIFO_EN, 0x00);
+    imuWrite1Byte(REG_USER_CTRL, 0x04);         // FIFO off + reset
+
+    if (used == 0) {
+        // FIFO came back empty; fall back to a direct read
+        return imu_readAccelNow(ax, ay, az);
+    }
+
+    ax = sx / used;
+    ay = sy / used;
+    az = sz / used;
+
+    #ifdef DEBUG_IMU
+    Serial.printf("[IMU] motion burst: %u samples ax=%.2f ay=%.2f az=%.2f\n",
+                  (unsigned)used, ax, ay, az);
+    #endif
+    return true;
+}
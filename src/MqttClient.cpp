@@ -1,7 +1,8 @@
 #include <WiFi.h>
-#include <WiFiClient.h>
-#include <PubSubClient.h>
+#include <mqtt_client.h>
 #include <stdarg.h>
+#include <memory>
+#include <ArduinoJson.h>
 
 #include "MqttClient.h"
 
@@ -12,6 +13,10 @@ extern ConfigState g_config;
 static const char* TOPIC_ATEM_PREVIEW   = "sanctuary/atem/preview";
 static const char* TOPIC_ATEM_PROGRAM   = "sanctuary/atem/program";
 static const char* TOPIC_ATEM_INPUTS    = "sanctuary/atem/inputs";
+static const char* TOPIC_ATEM_INPUTS_PATCH = "sanctuary/atem/inputs/patch";
+static const char* TOPIC_ATEM_INPUTS_MSGPACK       = "sanctuary/atem/inputs/msgpack";
+static const char* TOPIC_ATEM_INPUTS_PATCH_MSGPACK = "sanctuary/atem/inputs/patch/msgpack";
+static const char* TOPIC_ATEM_TALLY     = "sanctuary/atem/tally";
 
 static const char* TOPIC_GLOBAL_CONFIG_ROOT = "sanctuary/tally/config";
 static const char* TOPIC_ALL_CMD            = "sanctuary/tally/all/cmd";
@@ -19,9 +24,18 @@ static const char* TOPIC_ALL_CMD            = "sanctuary/tally/all/cmd";
 static const char* AVAILABILITY_SUBTOPIC = "availability";
 static const char* STATUS_ROOT_SUBTOPIC  = "status";
 
-static const uint32_t RECONNECT_INTERVAL_MS = 5000;
+// Reconnect backoff: fast jittered first retry, then full jitter over an
+// exponentially growing ceiling
+static const uint32_t RECONNECT_FIRST_MAX_MS = 500;
+static const uint32_t RECONNECT_BASE_MS      = 1000;
+static const uint32_t RECONNECT_CAP_MS       = 60000;
 
-// We’ll use this static pointer so PubSubClient can call back into the instance
+static const int      MQTT_BUFFER_SIZE   = 4096;  // inbound/outbound packet buffer
+static const int      MQTT_KEEPALIVE_SEC = 60;
+static const UBaseType_t MQTT_RX_QUEUE_LEN = 32;   // reassembled messages awaiting loop()
+static const uint32_t MQTT_RX_MAX_PAYLOAD = 16384; // refuse anything bigger
+
+// Static pointer for logf() (global helper, no instance at hand)
 static MqttClient* s_instance = nullptr;
 
 // Global logging helper implementation. This uses Serial for local debug and,
@@ -38,9 +52,8 @@ void logf(LogLevel level, const char* fmt, ...) {
     // Always print to Serial (if available)
     Serial.print(buf);
 
-    // If we have an MQTT client instance and it's marked connected, try to
-    // forward the log line over MQTT as well.
-    if (s_instance && g_config.device.mqtt_isConnected) {
+    // Forward the line over MQTT as well (buffered while disconnected)
+    if (s_instance) {
         s_instance->publishLog(String(buf), level);
     }
 }
@@ -57,230 +70,390 @@ MqttClient::MqttClient(ConfigState& cfg, TallyState& tally)
 
 void MqttClient::begin() {
     setupClient();
-    // First connect attempt
-    ensureConnected();
 }
 
 void MqttClient::loop() {
-    if (!_mqtt) return;
+    if (!_client) return;
 
-    if (!_mqtt->loop()) {
-        // Lost connection
+    // Connection edges reported by the MQTT task
+    bool up = _transportUp.load();
+    if (up && !_connected) {
+        onConnected();
+    } else if (!up && _connected) {
         _connected = false;
+        g_config.device.mqtt_isConnected = false;
+        _outbox.setOnline(false);
+        _outageStartMs    = millis();
+        _reconnectAttempt = 0;
+        scheduleReconnect();
+        Serial.printf("[mqtt] Disconnected, retry in %lu ms\n",
+                      (unsigned long)(_nextReconnectAtMs - _outageStartMs));
     }
 
+    // Reconnect is only requested here; esp-mqtt does the work in its task
     if (!_connected) {
-        g_config.device.mqtt_isConnected = false;
         uint32_t now = millis();
-        if (now - _lastReconnectAttemptMs > RECONNECT_INTERVAL_MS) {
-            _lastReconnectAttemptMs = now;
-            ensureConnected();
+        if ((int32_t)(now - _nextReconnectAtMs) >= 0 && WiFi.status() == WL_CONNECTED) {
+            uint32_t t0 = micros();
+            esp_mqtt_client_reconnect(_client);
+            noteBlocked(t0);
+            _reconnectAttempt++;
+            scheduleReconnect();
         }
     }
 
-    // Debounced publish for status/input
-    if (_hasPendingSelectedInput && _connected && _mqtt) {
-        constexpr uint32_t DEBOUNCE_INPUT_MS = 150;
-        uint32_t now = millis();
-        if (now - _pendingSelectedInputChangedAtMs >= DEBOUNCE_INPUT_MS &&
-            _pendingSelectedInput != _lastPublishedSelectedInput) {
-            const String root = topicDeviceRoot() + "/" + STATUS_ROOT_SUBTOPIC + "/";
-            String topic   = root + "input";
-            String payload = String(_pendingSelectedInput);
-            _mqtt->publish(topic.c_str(), payload.c_str(), false);
-            _lastPublishedSelectedInput  = _pendingSelectedInput;
-            _hasPendingSelectedInput     = false;
-        }
+    // Drain inbound messages
+    InboundMessage* msg = nullptr;
+    while (_rxQueue && xQueueReceive(_rxQueue, &msg, 0) == pdTRUE) {
+        handleIncoming(*msg);
+        free(msg->topic);
+        free(msg->payload);
+        free(msg);
     }
 
-    // Debounced publish for status/tally
-    if (_hasPendingTallyColor && _connected && _mqtt) {
-        constexpr uint32_t DEBOUNCE_TALLY_MS = 100;
-        uint32_t now = millis();
-        if (now - _pendingTallyColorChangedAtMs >= DEBOUNCE_TALLY_MS &&
-            _pendingTallyColor != _lastPublishedTallyColor) {
-            const String root = topicDeviceRoot() + "/" + STATUS_ROOT_SUBTOPIC + "/";
-            String topic = root + "tally";
-            _mqtt->publish(topic.c_str(), _pendingTallyColor.c_str(), false);
-            _lastPublishedTallyColor  = _pendingTallyColor;
-            _hasPendingTallyColor     = false;
-        }
+    // State topics: debounced, deduplicated, rate-limited
+    if (_connected) {
+        _outbox.drain(millis(), _cfg.global.publishRatePerSec,
+                      [this](const char* subtopic, const String& value, bool retain) {
+                          publishRaw(_deviceRoot + "/" + subtopic, value, retain);
+                      });
     }
 }
 
-void MqttClient::publishAvailability(const String& state) {
-    if (!_connected) return;
+// xorshift32; seeded from the device ID in setupClient()
+uint32_t MqttClient::nextRandom() {
+    uint32_t x = _rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    _rng = x;
+    return x;
+}
 
-    String topic = topicDeviceRoot() + "/" + AVAILABILITY_SUBTOPIC;
-    _mqtt->publish(topic.c_str(), state.c_str(), true); // retained
+uint32_t MqttClient::reconnectDelayMs() {
+    if (_reconnectAttempt == 0) {
+        // Fast first retry. With a server-advertised window, each device
+        // takes its own slot in it instead.
+        uint32_t windowMs = (uint32_t)_cfg.global.reconnectWindowSec * 1000UL;
+        uint32_t slot = windowMs ? (_deviceSlot % windowMs) : 0;
+        return slot + nextRandom() % RECONNECT_FIRST_MAX_MS;
+    }
+
+    uint16_t shift = _reconnectAttempt - 1;
+    if (shift > 16) shift = 16;
+    uint32_t ceiling = RECONNECT_BASE_MS << shift;
+    if (ceiling > RECONNECT_CAP_MS) ceiling = RECONNECT_CAP_MS;
+    return nextRandom() % (ceiling + 1);
 }
 
-void MqttClient::publishStatus(const StatusSnapshot& st)
-{
-    if (!_connected) return;
+void MqttClient::scheduleReconnect() {
+    _nextReconnectAtMs = millis() + reconnectDelayMs();
+}
+
+uint32_t MqttClient::takeMaxBlockedUs() {
+    uint32_t v = _maxBlockedUs;
+    _maxBlockedUs = 0;
+    return v;
+}
+
+void MqttClient::publishAvailability(const String& state) {
+    _outbox.set(PubTopic::Availability, state); // retained
+}
+
+// Status values go either to their own topics, or (status_encoding
+// json/msgpack) into one document keyed by the subtopic minus "status/".
+class StatusSink {
+public:
+    StatusSink(PublishQueue& outbox, JsonDocument* batch)
+    : _outbox(outbox), _batch(batch) {}
+
+    template <typename T>
+    void put(PubTopic t, const T& value) {
+        if (_batch) (*_batch)[key(t)] = value;
+        else        _outbox.set(t, String(value));
+    }
+
+    void putFixed(PubTopic t, float value, unsigned decimals) {
+        if (_batch) {
+            float scale = 1.0f;
+            for (unsigned i = 0; i < decimals; ++i) scale *= 10.0f;
+            (*_batch)[key(t)] = roundf(value * scale) / scale;
+        } else {
+            _outbox.set(t, String(value, decimals));
+        }
+    }
+
+private:
+    static const char* key(PubTopic t) {
+        return PublishQueue::describe(t).subtopic + 7;   // past "status/"
+    }
 
-    const String root = topicDeviceRoot() + "/" + STATUS_ROOT_SUBTOPIC + "/";
+    PublishQueue& _outbox;
+    JsonDocument* _batch;
+};
 
-    auto pub = [&](const String& sub, const String& value) {
-        String topic = root + sub;
-        _mqtt->publish(topic.c_str(), value.c_str(), false);
-    };
+void MqttClient::publishStatus(const StatusSnapshot& st)
+{
+    const StatusEncoding enc = _cfg.global.statusEncoding;
+    JsonDocument batch;
+    StatusSink out(_outbox, enc == StatusEncoding::Topics ? nullptr : &batch);
 
     // Core status
-    pub("uptime", String(st.uptimeSec));
+    out.put(PubTopic::StatusUptime, st.uptimeSec);
 
     // Battery metrics
-    pub("battery_mv", String(st.batteryMv));
-    pub("battery_pct", String(st.batteryPct));
-    pub("battery_pct_coulomb", String(st.batPercentageCoulomb));
-    pub("battery_pct_hybrid", String(st.batPercentageHybrid));
-    pub("coulomb_count", String(st.coulombCount));
+    out.put(PubTopic::StatusBatteryMv, st.batteryMv);
+    out.put(PubTopic::StatusBatteryPct, st.batteryPct);
+    out.put(PubTopic::StatusBatteryPctCoulomb, st.batPercentageCoulomb);
+    out.put(PubTopic::StatusBatteryPctHybrid, st.batPercentageHybrid);
+    out.put(PubTopic::StatusCoulombCount, st.coulombCount);
 
     // Radio / environment
-    pub("rssi", String(st.rssi));
+    out.put(PubTopic::StatusRssi, st.rssi);
+    if (st.wifiConnectPath.length()) {
+        out.put(PubTopic::StatusWifiConnectPath, st.wifiConnectPath);
+        out.put(PubTopic::StatusWifiConnectMs, st.wifiConnectMs);
+    }
     if (!isnan(st.temperatureC)) {
-        pub("temperature", String(st.temperatureC, 1));
+        out.putFixed(PubTopic::StatusTemperature, st.temperatureC, 1);
+    }
+
+    if (st.bootToTallyMs) {
+        out.put(PubTopic::StatusBootToTallyMs, st.bootToTallyMs);
     }
 
+    // Display pipeline
+    out.put(PubTopic::StatusDisplayBlockedUs, st.displayBlockedMaxUs);
+    out.put(PubTopic::StatusLoopMaxMs, st.loopMaxMs);
+
+    // MQTT transport
+    out.put(PubTopic::StatusMqttBlockedUs, st.mqttBlockedMaxUs);
+    out.put(PubTopic::StatusMqttRxDropped, st.mqttRxDropped);
+    if (st.mqttRecoverMs) {
+        out.put(PubTopic::StatusMqttRecoverMs, st.mqttRecoverMs);
+        out.put(PubTopic::StatusMqttRecoverAttempts, st.mqttRecoverAttempts);
+    }
+    out.put(PubTopic::StatusMqttReplayed, st.mqttReplayed);
+    out.put(PubTopic::StatusMqttDropped, st.mqttDropped);
+    out.put(PubTopic::StatusTallyCoalesced, st.tallyCoalesced);
+    out.put(PubTopic::StatusTallyCoalesceTimeouts, st.tallyCoalesceTimeouts);
+    out.put(PubTopic::StatusUdpTallyRx, st.udpTallyRx);
+    out.put(PubTopic::StatusUdpTallyRejected, st.udpTallyRejected);
+    out.put(PubTopic::StatusAtemLink, st.atemLink);
+    out.put(PubTopic::StatusAtemResends, st.atemResends);
+    out.put(PubTopic::StatusTslRx, st.tslRx);
+    out.put(PubTopic::StatusTslRejected, st.tslRejected);
+
     // Device metadata
-    pub("restarts", String(st.restartCount));
+    out.put(PubTopic::StatusRestarts, st.restartCount);
     if (st.firmwareVersion.length()) {
-        pub("firmware_version", st.firmwareVersion);
+        out.put(PubTopic::StatusFirmwareVersion, st.firmwareVersion);
     }
     if (st.buildDateTime.length()) {
-        pub("buildDateTime", st.buildDateTime);
+        out.put(PubTopic::StatusBuildDateTime, st.buildDateTime);
     }
     if (st.hwRevision.length()) {
-        pub("hw_revision", st.hwRevision);
+        out.put(PubTopic::StatusHwRevision, st.hwRevision);
+    }
+
+    if (enc == StatusEncoding::Json) {
+        String doc;
+        serializeJson(batch, doc);
+        _outbox.set(PubTopic::StatusBatch, doc);
+    } else if (enc == StatusEncoding::MsgPack) {
+        // Binary: ArduinoJson's String writer stops at NUL bytes, so
+        // serialize into a buffer and copy it with an explicit length
+        const size_t len = measureMsgPack(batch);
+        std::unique_ptr<char[]> buf(new char[len + 1]);
+        serializeMsgPack(batch, buf.get(), len + 1);
+        _outbox.set(PubTopic::StatusBatch, String(buf.get(), len));
     }
 }
 
 void MqttClient::publishSelectedInput(uint8_t input) {
-    // Schedule a debounced publish of the selected input (numeric ID).
-    _pendingSelectedInput            = input;
-    _hasPendingSelectedInput         = true;
-    _pendingSelectedInputChangedAtMs = millis();
+    // Debounced (see PublishQueue): rapid cycling sends only where it lands
+    _outbox.set(PubTopic::StatusInput, String(input));
 
-    // Also publish the ATEM short and long names for this input immediately, if known.
+    // Also the ATEM short and long names for this input, if known.
     const AtemInputInfo* info = _tally.findInput(input);
-    if (_connected && _mqtt && info) {
-        const String root = topicDeviceRoot() + "/" + STATUS_ROOT_SUBTOPIC + "/";
-
-        // Publish short_name
+    if (info) {
         if (info->shortName.length() > 0) {
-            String topicShort = root + "short_name";
-            _mqtt->publish(topicShort.c_str(), info->shortName.c_str(), false);
+            _outbox.set(PubTopic::StatusShortName, info->shortName);
         }
-
-        // Publish long_name
         if (info->longName.length() > 0) {
-            String topicLong = root + "long_name";
-            _mqtt->publish(topicLong.c_str(), info->longName.c_str(), false);
+            _outbox.set(PubTopic::StatusLongName, info->longName);
         }
     }
 }
 
 void MqttClient::publishTallyColor(const String& color) {
-    _pendingTallyColor            = color;
-    _hasPendingTallyColor         = true;
-    _pendingTallyColorChangedAtMs = millis();
+    _outbox.set(PubTopic::StatusTally, color);
 }
 
-void MqttClient::publishLog(const String& line, LogLevel level) {
-    if (!_connected) return;
+void MqttClient::publishConfigEcho(const String& json) {
+    _outbox.set(PubTopic::StatusConfig, json);
+}
+
+void MqttClient::publishCommandAck(const MqttCommand& cmd, CommandAckStatus status) {
+    char buf[128];
+    int n = snprintf(buf, sizeof(buf),
+                     "{\"seq\":%lu,\"cmd\":\"%s\",\"status\":\"%s\",\"latency_ms\":%lu",
+                     (unsigned long)cmd.seq, commandName(cmd.type),
+                     commandAckStatusName(status),
+                     (unsigned long)(millis() - cmd.receivedMs));
+    if (cmd.id != 0 && n > 0 && n < (int)sizeof(buf)) {
+        n += snprintf(buf + n, sizeof(buf) - n, ",\"id\":%lu", (unsigned long)cmd.id);
+    }
+    if (n > 0 && n < (int)sizeof(buf) - 1) {
+        buf[n++] = '}';
+        buf[n]   = '\0';
+    }
+
+    _outbox.push(PubStream::CommandAck, buf);
+}
 
+void MqttClient::publishLog(const String& line, LogLevel level) {
     // Respect global log level
     if (static_cast<uint8_t>(level) > static_cast<uint8_t>(_cfg.device.logLevel)) {
         return;
     }
 
-    String topic = topicDeviceRoot() + "/" + STATUS_ROOT_SUBTOPIC + "/log";
-    _mqtt->publish(topic.c_str(), line.c_str(), false);
+    _outbox.push(PubStream::Log, line.c_str());
 }
 
 // --- Internal setup -------------------------------------------
 
 void MqttClient::setupClient() {
-    if (_wifiClient || _mqtt) return;
-
-    _wifiClient = new WiFiClient();
-    _mqtt = new PubSubClient(*_wifiClient);
+    if (_client) return;
 
-    // ✅ Use the underlying persistent config instead
-    _mqtt->setServer(_cfg.global.mqttServer.c_str(), _cfg.global.mqttPort);
-    _mqtt->setCallback(&MqttClient::_mqttCallbackThunk);
-}
-
-void MqttClient::ensureConnected() {
-    if (_connected || !_mqtt) return;
+    const auto eff = _cfg.effective();
 
-    // Don’t even try if Wi-Fi is down; avoids useless DNS/TCP attempts
-    if (WiFi.status() != WL_CONNECTED) {
+    // Everything esp-mqtt or its task reads is fixed here
+    _deviceRoot = topicDeviceRoot();
+    _clientId   = eff.deviceId + "-" + String((uint32_t)esp_random(), HEX);
+    _lwtTopic   = _deviceRoot + "/" + AVAILABILITY_SUBTOPIC;
+    _host       = _cfg.global.mqttServer;
+    _username   = eff.mqttUsername;
+    _password   = eff.mqttPassword;
+
+    _rxQueue = xQueueCreate(MQTT_RX_QUEUE_LEN, sizeof(InboundMessage*));
+
+    // FNV-1a of the device ID: stable per device, different across the fleet
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < eff.deviceId.length(); ++i) {
+        h ^= (uint8_t)eff.deviceId[i];
+        h *= 16777619u;
+    }
+    _deviceSlot = h;
+    _rng = h ? h : 0x9E3779B9u;
+
+    esp_mqtt_client_config_t mc = {};
+    mc.host        = _host.c_str();
+    mc.port        = _cfg.global.mqttPort;
+    mc.transport   = MQTT_TRANSPORT_OVER_TCP;
+    mc.client_id   = _clientId.c_str();
+    if (_username.length() > 0) {
+        mc.username = _username.c_str();
+        mc.password = _password.c_str();
+    }
+    mc.lwt_topic   = _lwtTopic.c_str();
+    mc.lwt_msg     = "offline";
+    mc.lwt_qos     = 0;
+    mc.lwt_retain  = 1;
+    mc.keepalive   = MQTT_KEEPALIVE_SEC;
+    mc.buffer_size = MQTT_BUFFER_SIZE;
+    mc.disable_auto_reconnect = true;   // loop() paces reconnects
+
+    _client = esp_mqtt_client_init(&mc);
+    if (!_client) {
+        Serial.println("[mqtt] esp_mqtt_client_init failed");
         return;
     }
+    esp_mqtt_client_register_event(_client, MQTT_EVENT_ANY, &MqttClient::_mqttEventThunk, this);
+    esp_mqtt_client_start(_client);
 
-    if (connectOnce()) {
-        _connected = true;
-        g_config.device.mqtt_isConnected = true;
-        subscribeAll();
-        publishAvailability("online");
-        publishLog("MQTT connected");
-    }
+    // esp_mqtt_client_start() is the first attempt
+    _outageStartMs    = millis();
+    _reconnectAttempt = 1;
+    scheduleReconnect();
 }
 
-bool MqttClient::connectOnce() {
-    const auto eff = _cfg.effective();
+// Loop side of a new session: the subscriptions were already sent from
+// the MQTT task (CONNECTED / SUBSCRIBED events).
+void MqttClient::onConnected() {
+    _connected = true;
+    g_config.device.mqtt_isConnected = true;
+    _outbox.forgetSent();   // new session may be a restarted broker
+    _outbox.setOnline(true);
+
+    if (_everConnected) {
+        _lastRecoverMs       = millis() - _outageStartMs;
+        _lastRecoverAttempts = _reconnectAttempt;
+        Serial.printf("[mqtt] Reconnected after %lu ms (%u attempts)\n",
+                      (unsigned long)_lastRecoverMs, (unsigned)_lastRecoverAttempts);
+    }
+    _everConnected    = true;
+    _reconnectAttempt = 0;
+    publishAvailability("online");
+    publishLog("MQTT connected");
+}
 
-    // Client ID = deviceId + random suffix
-    String clientId = eff.deviceId + "-" + String((uint32_t)esp_random(), HEX);
-
-    // LWT topic
-    String lwtTopic = topicDeviceRoot() + "/" + AVAILABILITY_SUBTOPIC;
-    const char* lwtPayload = "offline";
-
-    if (eff.mqttUsername.length() > 0) {
-        return _mqtt->connect(
-            clientId.c_str(),
-            eff.mqttUsername.c_str(),
-            eff.mqttPassword.c_str(),
-            lwtTopic.c_str(),
-            0,      // qos
-            true,   // retained
-            lwtPayload
-        );
-    } else {
-        return _mqtt->connect(
-            clientId.c_str(),
-            lwtTopic.c_str(),
-            0,
-            true,
-            lwtPayload
-        );
+// Runs in the MQTT task (CONNECTED event); uses only fixed strings.
+// Tally state (combined, program, preview) goes first, on its own: the broker sends their retained
+// values right after the SUBACK, ahead of the config/# burst that the
+// remaining subscriptions trigger.
+void MqttClient::subscribePriority() {
+    esp_mqtt_client_subscribe(_client, TOPIC_ATEM_TALLY, 0);
+    esp_mqtt_client_subscribe(_client, TOPIC_ATEM_PROGRAM, 0);
+    _prioritySubMsgId = esp_mqtt_client_subscribe(_client, TOPIC_ATEM_PREVIEW, 0);
+    if (_prioritySubMsgId < 0) {
+        subscribeRest();   // couldn't queue it; don't hold the rest back
     }
 }
 
-void MqttClient::subscribeAll() {
-    const auto eff = _cfg.effective();
+// Runs in the MQTT task once the priority SUBACK arrives.
+void MqttClient::subscribeRest() {
+    _prioritySubMsgId = -1;
 
-    // 1) ATEM topics (global)
-    _mqtt->subscribe(TOPIC_ATEM_PREVIEW);
-    _mqtt->subscribe(TOPIC_ATEM_PROGRAM);
-    _mqtt->subscribe(TOPIC_ATEM_INPUTS);
+    // 1) ATEM input labels (global): baseline first, so a retained patch
+    //    is applied on top of it
+    esp_mqtt_client_subscribe(_client, TOPIC_ATEM_INPUTS, 0);
+    esp_mqtt_client_subscribe(_client, TOPIC_ATEM_INPUTS_MSGPACK, 0);
+    esp_mqtt_client_subscribe(_client, TOPIC_ATEM_INPUTS_PATCH, 0);
+    esp_mqtt_client_subscribe(_client, TOPIC_ATEM_INPUTS_PATCH_MSGPACK, 0);
 
     // 2) Global config
     // subscribe to sanctuary/tally/config/#
     String globalCfg = String(TOPIC_GLOBAL_CONFIG_ROOT) + "/#";
-    _mqtt->subscribe(globalCfg.c_str());
+    esp_mqtt_client_subscribe(_client, globalCfg.c_str(), 0);
 
     // 3) Global commands
-    _mqtt->subscribe(TOPIC_ALL_CMD);
+    esp_mqtt_client_subscribe(_client, TOPIC_ALL_CMD, 0);
 
     // 4) Per-device config + commands
-    String devConfigRoot = topicDeviceConfigRoot() + "/#";  // sanctuary/tally/{device}/config/#
-    _mqtt->subscribe(devConfigRoot.c_str());
+    // "x/#" also matches "x" itself, so both subscriptions include the
+    // config document topic
+    String devConfigRoot = _deviceRoot + "/config/#";  // sanctuary/tally/{device}/config/#
+    esp_mqtt_client_subscribe(_client, devConfigRoot.c_str(), 0);
+
+    String devCmd = _deviceRoot + "/cmd";
+    esp_mqtt_client_subscribe(_client, devCmd.c_str(), 0);
+}
 
-    String devCmd = topicDeviceRoot() + "/cmd";
-    _mqtt->subscribe(devCmd.c_str());
+// Hand a message to the esp-mqtt outbox; the MQTT task does the socket write.
+void MqttClient::publishRaw(const String& topic, const String& payload, bool retain) {
+    if (!_client) return;
+    uint32_t t0 = micros();
+    esp_mqtt_client_enqueue(_client, topic.c_str(), payload.c_str(), payload.length(),
+                            0, retain ? 1 : 0, true);
+    noteBlocked(t0);
+}
+
+void MqttClient::noteBlocked(uint32_t startUs) {
+    uint32_t dt = micros() - startUs;
+    if (dt > _maxBlockedUs) {
+        _maxBlockedUs = dt;
+    }
 }
 
 // --- Topic helpers --------------------------------------------
@@ -295,19 +468,90 @@ String MqttClient::topicDeviceConfigRoot() const {
 
 // --- Callback plumbing ----------------------------------------
 
-void MqttClient::_mqttCallbackThunk(char* topic, uint8_t* payload, unsigned int length) {
-    if (s_instance) {
-        s_instance->handleIncoming(topic, payload, length);
+void MqttClient::_mqttEventThunk(void* arg, const char* base, int32_t eventId, void* eventData) {
+    (void)base;
+    MqttClient* self = static_cast<MqttClient*>(arg);
+    esp_mqtt_event_handle_t ev = static_cast<esp_mqtt_event_handle_t>(eventData);
+
+    switch ((esp_mqtt_event_id_t)eventId) {
+        case MQTT_EVENT_CONNECTED:
+            self->subscribePriority();
+            self->_transportUp.store(true);
+            break;
+        case MQTT_EVENT_SUBSCRIBED:
+            if (ev->msg_id == self->_prioritySubMsgId) {
+                self->subscribeRest();
+            }
+            break;
+        case MQTT_EVENT_DISCONNECTED:
+            self->_transportUp.store(false);
+            break;
+        case MQTT_EVENT_DATA:
+            self->onData(ev);
+            break;
+        default:
+            break;
     }
 }
 
-void MqttClient::handleIncoming(const char* topic, const uint8_t* payload, unsigned int length) {
-    String t(topic);
-    String p;
-    p.reserve(length + 1);
-    for (unsigned int i = 0; i < length; ++i) {
-        p += static_cast<char>(payload[i]);
+// Reassemble (possibly fragmented) DATA events into one message and queue
+// it for loop(). Runs in the MQTT task.
+void MqttClient::onData(const void* event) {
+    const esp_mqtt_event_t* ev = static_cast<const esp_mqtt_event_t*>(event);
+
+    // First fragment carries the topic and total length
+    if (ev->current_data_offset == 0) {
+        if (_rxPartial) {   // previous message never completed
+            free(_rxPartial->topic);
+            free(_rxPartial->payload);
+            free(_rxPartial);
+            _rxPartial = nullptr;
+            _rxDropped.fetch_add(1);
+        }
+        if ((uint32_t)ev->total_data_len > MQTT_RX_MAX_PAYLOAD) {
+            _rxDropped.fetch_add(1);
+            return;
+        }
+        InboundMessage* m = static_cast<InboundMessage*>(malloc(sizeof(InboundMessage)));
+        char* topic   = static_cast<char*>(malloc(ev->topic_len + 1));
+        char* payload = static_cast<char*>(malloc(ev->total_data_len + 1));
+        if (!m || !topic || !payload) {
+            free(m); free(topic); free(payload);
+            _rxDropped.fetch_add(1);
+            return;
+        }
+        memcpy(topic, ev->topic, ev->topic_len);
+        topic[ev->topic_len] = '\0';
+        payload[ev->total_data_len] = '\0';
+        m->topic      = topic;
+        m->payload    = payload;
+        m->payloadLen = ev->total_data_len;
+        _rxPartial = m;
+    }
+
+    if (!_rxPartial) {
+        return;   // continuation of a message we dropped
+    }
+    if ((uint32_t)(ev->current_data_offset + ev->data_len) > _rxPartial->payloadLen) {
+        return;
     }
+    memcpy(_rxPartial->payload + ev->current_data_offset, ev->data, ev->data_len);
+
+    if ((uint32_t)(ev->current_data_offset + ev->data_len) == _rxPartial->payloadLen) {
+        InboundMessage* done = _rxPartial;
+        _rxPartial = nullptr;
+        if (xQueueSend(_rxQueue, &done, 0) != pdTRUE) {
+            free(done->topic);
+            free(done->payload);
+            free(done);
+            _rxDropped.fetch_add(1);
+        }
+    }
+}
+
+void MqttClient::handleIncoming(const InboundMessage& msg) {
+    String t(msg.topic);
+    String p(msg.payload, msg.payloadLen);   // may be binary (MessagePack)
 
     // Simple routing: just hand everything to user-provided handler.
     // Higher-level parsing (config vs commands vs atem vs inputs)
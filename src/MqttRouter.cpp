@@ -1,7 +1,11 @@
 #include <ArduinoJson.h>
+#include <errno.h>
+#include <vector>
 #include "MqttRouter.h"
 #include "MqttClient.h"
-#include "NetworkModule.h"
+#include "ConfigSchema.h"
+#include "PrefsModule.h"
+#include "TimeModule.h"
 
 extern MqttClient g_mqtt;
 
@@ -9,10 +13,40 @@ extern MqttClient g_mqtt;
 static const char* TOPIC_ATEM_PREVIEW = "sanctuary/atem/preview";
 static const char* TOPIC_ATEM_PROGRAM = "sanctuary/atem/program";
 static const char* TOPIC_ATEM_INPUTS  = "sanctuary/atem/inputs";
+static const char* TOPIC_ATEM_INPUTS_PATCH = "sanctuary/atem/inputs/patch";
+static const char* TOPIC_ATEM_INPUTS_MSGPACK       = "sanctuary/atem/inputs/msgpack";
+static const char* TOPIC_ATEM_INPUTS_PATCH_MSGPACK = "sanctuary/atem/inputs/patch/msgpack";
+static const char* TOPIC_ATEM_TALLY   = "sanctuary/atem/tally";
 
 static const char* TOPIC_GLOBAL_CONFIG_ROOT = "sanctuary/tally/config";
 static const char* TOPIC_ALL_CMD            = "sanctuary/tally/all/cmd";
 
+// Config coalescing: apply once no config key arrived for SETTLE_MS, but
+// never hold a key longer than MAX_DEFER_MS.
+static const uint32_t CONFIG_SETTLE_MS    = 250;
+static const uint32_t CONFIG_MAX_DEFER_MS = 1500;
+
+struct PendingConfigKey {
+    bool   perDevice;
+    String key;
+    String payload;
+};
+
+static std::vector<PendingConfigKey> s_pendingConfig;
+static uint32_t s_firstPendingConfigMs = 0;
+static uint32_t s_lastPendingConfigMs  = 0;
+
+// Config documents (sanctuary/tally/config, .../{device}/config): the
+// version last applied, so a repeat is skipped, and its keys, so keys a
+// new version drops can be reset.
+struct ConfigDocState {
+    bool     applied = false;
+    uint32_t version = 0;
+    std::vector<String> keys;
+};
+
+static ConfigDocState s_configDoc[2];   // [0] global, [1] per-device
+
 // ---------- Helpers -------------------------------------------------
 
 static String toLowerCopy(const String& in) {
@@ -21,26 +55,8 @@ static String toLowerCopy(const String& in) {
     return s;
 }
 
-static WifiSleepMode parseWifiSleep(const String& s) {
-    String v = toLowerCopy(s);
-    if (v == "none")  return WifiSleepMode::None;
-    if (v == "light") return WifiSleepMode::Light;
-    if (v == "modem") return WifiSleepMode::Modem;
-    return WifiSleepMode::Modem; // default
-}
-
-static LogLevel parseLogLevel(const String& s) {
-    String v = toLowerCopy(s);
-    if (v == "none")  return LogLevel::None;
-    if (v == "error") return LogLevel::Error;
-    if (v == "warn")  return LogLevel::Warn;
-    if (v == "info")  return LogLevel::Info;
-    if (v == "debug") return LogLevel::Debug;
-    return LogLevel::Info;
-}
-
-static MqttCommandType parseCommand(const String& payload) {
-    String v = toLowerCopy(payload);
+static MqttCommandType parseCommandName(const String& name) {
+    String v = toLowerCopy(name);
     if (v == "deep_sleep")   return MqttCommandType::DeepSleep;
     if (v == "wakeup")       return MqttCommandType::Wakeup;
     if (v == "reboot")       return MqttCommandType::Reboot;
@@ -51,167 +67,510 @@ static MqttCommandType parseCommand(const String& payload) {
     return MqttCommandType::None;
 }
 
+const char* commandName(MqttCommandType type) {
+    switch (type) {
+        case MqttCommandType::DeepSleep:       return "deep_sleep";
+        case MqttCommandType::Wakeup:          return "wakeup";
+        case MqttCommandType::Reboot:          return "reboot";
+        case MqttCommandType::OtaUpdate:       return "ota_update";
+        case MqttCommandType::FactoryReset:    return "factory_reset";
+        case MqttCommandType::ResyncTime:      return "resync_time";
+        case MqttCommandType::selectNextInput: return "select_next_input";
+        default:                               return "none";
+    }
+}
+
+const char* commandAckStatusName(CommandAckStatus status) {
+    switch (status) {
+        case CommandAckStatus::Done:      return "done";
+        case CommandAckStatus::Coalesced: return "coalesced";
+        case CommandAckStatus::Dropped:   return "dropped";
+        case CommandAckStatus::Ignored:   return "ignored";
+    }
+    return "done";
+}
+
+// Payload is either the bare command name ("reboot") or JSON with an
+// optional correlation id: {"cmd":"reboot","id":42}
+static MqttCommand parseCommand(const String& payload) {
+    MqttCommand cmd;
+    if (payload.length() > 0 && payload[0] == '{') {
+        JsonDocument doc;
+        if (deserializeJson(doc, payload) == DeserializationError::Ok) {
+            cmd.type = parseCommandName(doc["cmd"] | "");
+            cmd.id   = doc["id"] | 0u;
+        }
+    } else {
+        cmd.type = parseCommandName(payload);
+    }
+    cmd.receivedMs = millis();
+    return cmd;
+}
+
+static void queueCommand(CommandQueue& commands, const String& payload) {
+    MqttCommand cmd = parseCommand(payload);
+    if (cmd.type == MqttCommandType::None) {
+        Serial.printf("[MQTT] Unknown command '%s'\n", payload.c_str());
+        return;
+    }
+    switch (commands.push(cmd)) {
+        case CommandQueue::PushResult::Queued:
+            break;
+        case CommandQueue::PushResult::Coalesced:
+            g_mqtt.publishCommandAck(cmd, CommandAckStatus::Coalesced);
+            break;
+        case CommandQueue::PushResult::Full:
+            Serial.printf("[MQTT] Command queue full, dropping %s\n", commandName(cmd.type));
+            g_mqtt.publishCommandAck(cmd, CommandAckStatus::Dropped);
+            break;
+    }
+}
+
 // ---------- ATEM routing --------------------------------------------
 
-static void handleAtemMessage(TallyState& tally, const String& topic, const String& payload) {
-    if (topic == TOPIC_ATEM_PROGRAM) {
-        tally.programInput = static_cast<uint8_t>(payload.toInt());
+// A source set is an array of input IDs ([1,4]), a bitmask number
+// (bit n = input n) or a bitmask string ("0x12"). IDs outside 1..63
+// (black, bars, media players) are skipped; anything that isn't a
+// number fails the set.
+static bool parseSourceSet(JsonVariantConst v, uint64_t& mask) {
+    if (v.is<JsonArrayConst>()) {
+        for (JsonVariantConst id : v.as<JsonArrayConst>()) {
+            if (!id.is<int>()) return false;
+            int n = id.as<int>();
+            if (n > 0 && n < 64) mask |= (1ULL << n);
+        }
+        return true;
+    }
+    if (v.is<const char*>()) {
+        const char* text = v.as<const char*>();
+        char* end = nullptr;
+        errno = 0;
+        uint64_t bits = strtoull(text, &end, 0);
+        if (!isdigit(static_cast<unsigned char>(*text)) || *end != '\0' || errno == ERANGE) return false;
+        mask |= bits;
+        return true;
+    }
+    if (v.is<uint64_t>()) {
+        mask |= v.as<uint64_t>();
+        return true;
+    }
+    return false;
+}
+
+// sanctuary/atem/tally: {"seq":N,"program":[..],"preview":[..]} (ME1) or,
+// per bus, {"seq":N,"buses":[{"bus":"me2","program":..,"preview":..},..]}
+// ("bus" optional: position in the array). Applied to TallyState in one
+// step so a cut never shows a half-updated state.
+static void handleCombinedTally(TallyState& tally, const String& payload) {
+    if (payload.length() == 0) {
+        // Retained topic cleared: fall back to the single topics
+        tally.combinedActive = false;
+        tally.resetBuses();
+        Serial.println("[MQTT] atem/tally cleared, using program/preview topics");
         return;
     }
-    if (topic == TOPIC_ATEM_PREVIEW) {
-        tally.previewInput = static_cast<uint8_t>(payload.toInt());
+    if (tally.directSourceActive(millis())) {
+        return;   // UDP fast path / TSL owns program/preview
+    }
+
+    JsonDocument doc;
+    DeserializationError err = deserializeJson(doc, payload);
+    if (err) {
+        Serial.printf("[MQTT] atem/tally JSON parse failed: %s\n", err.c_str());
         return;
     }
-    if (topic == TOPIC_ATEM_INPUTS) {
-        Serial.printf("[MQTT] ATEM_INPUTS topic received, payload length=%u\n", payload.length());
 
-        JsonDocument doc;  // ArduinoJson 7: elastic capacity on heap
-        DeserializationError err = deserializeJson(doc, payload);
-        if (err) {
-            Serial.printf("[MQTT] ATEM inputs JSON parse failed: %s (len=%u)\n",
-                        err.c_str(), payload.length());
-            return;
+    uint64_t program[TALLY_BUS_COUNT] = {};
+    uint64_t preview[TALLY_BUS_COUNT] = {};
+    bool ok = true;
+    JsonArrayConst buses = doc["buses"];
+    if (!buses.isNull()) {
+        uint8_t index = 0;
+        for (JsonVariantConst bus : buses) {
+            uint8_t b = index++;
+            const char* name = bus["bus"];
+            if (name) {
+                uint8_t bits = TallyState::parseBusList(String(name));
+                if (bits == 0) continue;   // unknown bus
+                for (b = 0; !(bits & (1u << b)); ++b) {}
+            }
+            if (b >= TALLY_BUS_COUNT) continue;
+            // A set may be left out (aux buses have no preview), but one
+            // that is there has to parse
+            JsonVariantConst p = bus["program"];
+            JsonVariantConst v = bus["preview"];
+            if ((!p.isNull() && !parseSourceSet(p, program[b])) ||
+                (!v.isNull() && !parseSourceSet(v, preview[b]))) {
+                ok = false;
+                break;
+            }
         }
+    } else {
+        ok = parseSourceSet(doc["program"], program[0]) &&
+             parseSourceSet(doc["preview"], preview[0]);
+    }
+    if (!ok) {
+        Serial.println("[MQTT] atem/tally malformed or missing program/preview, ignored");
+        return;
+    }
+
+    uint32_t seq = doc["seq"] | 0u;
+    if (!tally.applyCombined(seq, program, preview)) {
+        Serial.printf("[MQTT] atem/tally seq %lu out of order (have %lu), ignored\n",
+                      (unsigned long)seq, (unsigned long)tally.combinedSeq);
+    }
+}
+
+// ---------- ATEM input table ----------------------------------------
+//
+// Both the full map (sanctuary/atem/inputs) and merge-patches
+// (sanctuary/atem/inputs/patch) are applied in place: existing entries
+// keep their String buffers unless the text actually changed, and
+// normalizeSelected() only runs when the set of tally-enabled inputs did.
+
+// tally_enabled: "TRUE"/"FALSE" (any case) or a JSON bool
+static bool parseEnabled(JsonVariantConst v) {
+    if (v.is<bool>()) return v.as<bool>();
+    const char* s = v.as<const char*>();
+    return s != nullptr && strcasecmp(s, "true") == 0;
+}
+
+static void assignIfChanged(String& dst, JsonVariantConst v) {
+    const char* s = v.as<const char*>();
+    if (s == nullptr) s = "";   // null / missing resets the field
+    if (dst != s) dst = s;
+}
+
+// Apply one field; unknown keys are ignored. Returns true if
+// tallyEnabled changed.
+static bool mergeInputField(AtemInputInfo& info, const char* key, JsonVariantConst v) {
+    if (strcmp(key, "short_name") == 0) {
+        assignIfChanged(info.shortName, v);
+    } else if (strcmp(key, "long_name") == 0) {
+        assignIfChanged(info.longName, v);
+    } else if (strcmp(key, "tally_enabled") == 0) {
+        bool enabled = parseEnabled(v);
+        if (enabled != info.tallyEnabled) {
+            info.tallyEnabled = enabled;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Find or create the entry for id; a new entry starts disabled.
+static AtemInputInfo& inputEntry(TallyState& tally, uint8_t id) {
+    AtemInputInfo& info = tally.inputs[id];
+    if (info.id != id) {
+        info.id           = id;
+        info.tallyEnabled = false;
+    }
+    return info;
+}
 
-        tally.inputs.clear();
+static uint8_t inputIdFromKey(const char* key) {
+    int id = atoi(key);
+    return (id > 0 && id <= 255) ? static_cast<uint8_t>(id) : 0;
+}
 
-        JsonObject root = doc.as<JsonObject>();
-        for (JsonPair kv : root) {
-            const char* key = kv.key().c_str();   // "1", "2", ...
-            uint8_t id = static_cast<uint8_t>(atoi(key));
-            JsonObject obj = kv.value().as<JsonObject>();
+static void logInputsSummary(const TallyState& tally, const char* what) {
+    unsigned enabledCount = 0;
+    for (const auto& kv : tally.inputs) {
+        if (kv.second.tallyEnabled) ++enabledCount;
+    }
+    Serial.printf("[MQTT] ATEM inputs %s, enabled_count=%u, total=%u\n",
+                  what, enabledCount, (unsigned)tally.inputs.size());
+}
 
-            AtemInputInfo info;
-            info.id = id;
+// The .../msgpack topics carry the same maps as MessagePack
+static DeserializationError parseInputsDoc(JsonDocument& doc, const String& payload,
+                                           bool msgpack) {
+    return msgpack ? deserializeMsgPack(doc, payload) : deserializeJson(doc, payload);
+}
 
-            info.shortName = obj["short_name"].as<String>();
-            info.longName  = obj["long_name"].as<String>();
+// Full map: every listed entry gets all fields (missing ones reset),
+// entries not listed are removed.
+static void handleInputsBaseline(TallyState& tally, const String& payload, bool msgpack) {
+    Serial.printf("[MQTT] ATEM_INPUTS topic received, payload length=%u%s\n",
+                  payload.length(), msgpack ? " (msgpack)" : "");
+
+    JsonDocument doc;  // ArduinoJson 7: elastic capacity on heap
+    DeserializationError err = parseInputsDoc(doc, payload, msgpack);
+    if (err) {
+        Serial.printf("[MQTT] ATEM inputs parse failed: %s (len=%u)\n",
+                      err.c_str(), payload.length());
+        return;
+    }
 
-            String enabledStr = obj["tally_enabled"] | "FALSE";
-            enabledStr.toLowerCase();
-            info.tallyEnabled = (enabledStr == "true");
+    static const char* const FIELDS[] = { "short_name", "long_name", "tally_enabled" };
+    bool     enabledChanged = false;
+    uint64_t seen[4] = {};   // bit per input ID 0..255
 
-            tally.inputs[id] = info;
+    for (JsonPairConst kv : doc.as<JsonObjectConst>()) {
+        uint8_t id = inputIdFromKey(kv.key().c_str());   // "1", "2", ...
+        if (id == 0) continue;
+        seen[id >> 6] |= 1ULL << (id & 63);
 
-            Serial.printf(
-                "[MQTT] ATEM input %u: short=\"%s\" long=\"%s\" enabled=%d\n",
-                id,
-                info.shortName.c_str(),
-                info.longName.c_str(),
-                info.tallyEnabled ? 1 : 0
-            );
+        bool isNew = tally.inputs.find(id) == tally.inputs.end();
+        AtemInputInfo& info = inputEntry(tally, id);
+        JsonObjectConst obj = kv.value().as<JsonObjectConst>();
+        for (const char* field : FIELDS) {
+            enabledChanged |= mergeInputField(info, field, obj[field]);
         }
+        if (isNew && info.tallyEnabled) enabledChanged = true;
+    }
 
+    for (auto it = tally.inputs.begin(); it != tally.inputs.end(); ) {
+        uint8_t id = it->first;
+        if (seen[id >> 6] & (1ULL << (id & 63))) {
+            ++it;
+            continue;
+        }
+        if (it->second.tallyEnabled) enabledChanged = true;
+        it = tally.inputs.erase(it);
+    }
+
+    if (enabledChanged) {
         tally.normalizeSelected();
+    }
+    logInputsSummary(tally, "loaded");
+}
+
+// RFC 7386 merge-patch keyed by input ID: {"3":{"short_name":"WID"}}
+// updates one field, {"4":null} removes input 4, a null field resets it.
+static void handleInputsPatch(TallyState& tally, const String& payload, bool msgpack) {
+    if (payload.length() == 0) {
+        return;   // retained patch cleared
+    }
+
+    JsonDocument doc;
+    DeserializationError err = parseInputsDoc(doc, payload, msgpack);
+    if (err || !doc.is<JsonObjectConst>()) {
+        Serial.printf("[MQTT] ATEM inputs patch rejected: %s\n",
+                      err ? err.c_str() : "not an object");
+        return;
+    }
+
+    bool enabledChanged = false;
+    unsigned touched = 0;
 
-        unsigned enabledCount = 0;
+    for (JsonPairConst kv : doc.as<JsonObjectConst>()) {
+        uint8_t id = inputIdFromKey(kv.key().c_str());
+        if (id == 0) continue;
+        touched++;
 
-        // tally.inputs is a std::map<uint8_t, AtemInputInfo>
-        for (std::map<uint8_t, AtemInputInfo>::const_iterator it = tally.inputs.begin();
-            it != tally.inputs.end();
-            ++it) {
-            if (it->second.tallyEnabled) {
-                ++enabledCount;
+        if (kv.value().isNull()) {
+            auto it = tally.inputs.find(id);
+            if (it != tally.inputs.end()) {
+                if (it->second.tallyEnabled) enabledChanged = true;
+                tally.inputs.erase(it);
             }
+            continue;
         }
 
-        Serial.printf(
-            "[MQTT] ATEM inputs loaded, enabled_count=%u, total=%u\n",
-            enabledCount,
-            (unsigned)tally.inputs.size()
-        );
+        JsonObjectConst obj = kv.value().as<JsonObjectConst>();
+        if (obj.isNull()) continue;   // not an object: nothing to merge
+
+        AtemInputInfo& info = inputEntry(tally, id);
+        for (JsonPairConst field : obj) {
+            enabledChanged |= mergeInputField(info, field.key().c_str(), field.value());
+        }
     }
+
+    if (enabledChanged) {
+        tally.normalizeSelected();
+    }
+    Serial.printf("[MQTT] ATEM inputs patch: %u entries\n", touched);
 }
 
-// ---------- Global config routing -----------------------------------
-
-static void handleGlobalConfig(ConfigState& cfg, const String& key, const String& payload) {
-    // key is the part after sanctuary/tally/config/
-    if (key == "mqtt_server") {
-        cfg.global.mqttServer = payload;
-    } else if (key == "mqtt_port") {
-        cfg.global.mqttPort = static_cast<uint16_t>(payload.toInt());
-    } else if (key == "mqtt_username") {
-        cfg.global.mqttUsername = payload;
-    } else if (key == "mqtt_password") {
-        cfg.global.mqttPassword = payload;
-    } else if (key == "ntp_server") {
-        cfg.global.ntpServer = payload;
-        requestTimeInit();   // debounce: mark time init requested
-    } else if (key == "timezone") {
-        cfg.global.timeZone = payload;
-        requestTimeInit();   // debounce: mark time init requested
-    }
-
-    // Display / tally
-    else if (key == "brightness") {
-        int v = payload.toInt();
-        if (v >= 0 && v <= 100) {
-            cfg.global.brightness = static_cast<uint8_t>(v);
+static void handleAtemMessage(TallyState& tally, uint16_t coalesceMs,
+                              const String& topic, const String& payload) {
+    if (tally.atemDirect) {
+        return;   // talking to the switcher directly
+    }
+
+    if (topic == TOPIC_ATEM_TALLY) {
+        handleCombinedTally(tally, payload);
+        return;
+    }
+
+    // Single topics are the fallback once the combined one (or a direct
+    // source) is in use
+    if (topic == TOPIC_ATEM_PROGRAM) {
+        if (tally.combinedActive || tally.directSourceActive(millis())) return;
+        tally.stageProgram(static_cast<uint8_t>(payload.toInt()), millis(), coalesceMs);
+        return;
+    }
+    if (topic == TOPIC_ATEM_PREVIEW) {
+        if (tally.combinedActive || tally.directSourceActive(millis())) return;
+        tally.stagePreview(static_cast<uint8_t>(payload.toInt()), millis(), coalesceMs);
+        return;
+    }
+    if (topic == TOPIC_ATEM_INPUTS || topic == TOPIC_ATEM_INPUTS_MSGPACK) {
+        handleInputsBaseline(tally, payload, topic == TOPIC_ATEM_INPUTS_MSGPACK);
+        return;
+    }
+    if (topic == TOPIC_ATEM_INPUTS_PATCH || topic == TOPIC_ATEM_INPUTS_PATCH_MSGPACK) {
+        handleInputsPatch(tally, payload, topic == TOPIC_ATEM_INPUTS_PATCH_MSGPACK);
+        return;
+    }
+}
+
+// ---------- Config coalescing ---------------------------------------
+
+// Record a config key for the next apply pass (latest value wins).
+static void queueConfigKey(bool perDevice, const String& key, const String& payload) {
+    uint32_t now = millis();
+    if (s_pendingConfig.empty()) {
+        s_firstPendingConfigMs = now;
+    }
+    s_lastPendingConfigMs = now;
+
+    for (PendingConfigKey& p : s_pendingConfig) {
+        if (p.perDevice == perDevice && p.key == key) {
+            p.payload = payload;
+            return;
         }
-    } else if (key == "powersaver_brightness") {
-        int v = payload.toInt();
-        if (v >= 0 && v <= 100) {
-            cfg.global.powersaverBrightness = static_cast<uint8_t>(v);
+    }
+    s_pendingConfig.push_back(PendingConfigKey{perDevice, key, payload});
+}
+
+// Document values go through the same handlers as the per-key topics,
+// which take the payload text: strings as-is, anything else as JSON.
+static String configValueText(JsonVariantConst v) {
+    if (v.is<const char*>()) {
+        return String(v.as<const char*>());
+    }
+    String text;
+    serializeJson(v, text);
+    return text;
+}
+
+// {"version":7,"brightness":"60","timezone":"Etc/UTC",...}: all keys of
+// one scope in a single retained message. Keys whose value differs from
+// the applied config, and keys the previous version had but this one
+// drops (reset to default), are queued together and applied in one pass.
+static void handleConfigDocument(const ConfigState& cfg, bool perDevice,
+                                 const String& payload) {
+    ConfigDocState& state = s_configDoc[perDevice ? 1 : 0];
+    const char* scope = perDevice ? "device" : "global";
+
+    if (payload.length() == 0) {
+        state = ConfigDocState();   // retained document cleared
+        return;
+    }
+
+    JsonDocument doc;
+    DeserializationError err = deserializeJson(doc, payload);
+    if (err || !doc.is<JsonObjectConst>() || !doc["version"].is<uint32_t>()) {
+        Serial.printf("[MQTT] %s config document rejected: %s\n",
+                      scope, err ? err.c_str() : "missing version");
+        return;
+    }
+
+    uint32_t version = doc["version"].as<uint32_t>();
+    if (state.applied && version == state.version) {
+        return;   // e.g. the retained copy again after a reconnect
+    }
+
+    const ConfigScope cfgScope = perDevice ? ConfigScope::Device : ConfigScope::Global;
+    JsonObjectConst obj = doc.as<JsonObjectConst>();
+
+    // Dropped from this version: back to the default (empty payload)
+    unsigned changed = 0;
+    for (const String& key : state.keys) {
+        if (obj[key].isNull()) {
+            queueConfigKey(perDevice, key, String());
+            changed++;
         }
-    } else if (key == "powersaver_battery_pct") {
-        int v = payload.toInt();
-        if (v >= 0 && v <= 100) cfg.global.powersaverBatteryPct = static_cast<uint8_t>(v);
-    } else if (key == "tally_color_program") {
-        cfg.global.tallyColorProgram = payload;
-    } else if (key == "tally_color_preview") {
-        cfg.global.tallyColorPreview = payload;
-    }
-
-    // Wi-Fi tuning
-    else if (key == "wifi_tx_power") {
-        cfg.global.wifiTxPowerDbm = static_cast<int8_t>(payload.toInt());
-    } else if (key == "wifi_sleep") {
-        cfg.global.wifiSleep = parseWifiSleep(payload);
-    } else if (key == "status_interval") {
-        uint16_t v = static_cast<uint16_t>(payload.toInt());
-        if (v == 0) v = DEFAULT_STATUS_INTERVAL_SEC;
-        cfg.global.statusIntervalSec = v;
-    } else if (key == "idle_dim_seconds") {
-        int v = payload.toInt();
-        if (v < 0)   v = 0;
-        if (v > 65535) v = 65535;
-        cfg.global.idleDimSeconds = static_cast<uint16_t>(v);
-    }
-
-
-    // OTA (future) – we just store them, even though we don't act on them yet
-    else if (key == "firmware_url") {
-        // optional: store in a global String if you add one later
-        // e.g. cfg.global.firmwareUrl = payload;
-    } else if (key == "firmware_auto") {
-        // optional: parse as bool and store if you add it to ConfigState
     }
+
+    std::vector<String> keys;
+    for (JsonPairConst kv : obj) {
+        const char* key = kv.key().c_str();
+        if (strcmp(key, "version") == 0) continue;
+        keys.emplace_back(key);
+
+        // Compare with what is actually in effect: catches per-key topic
+        // changes since the last document and values that were rejected
+        String value = configValueText(kv.value());
+        const ConfigKeyDesc* desc = configSchema_find(cfgScope, String(key));
+        if (desc && configSchema_format(cfg, *desc) == value) continue;
+
+        queueConfigKey(perDevice, key, value);
+        changed++;
+    }
+
+    state.applied = true;
+    state.version = version;
+    state.keys    = std::move(keys);
+    Serial.printf("[MQTT] %s config document v%lu: %u keys changed\n",
+                  scope, (unsigned long)version, changed);
 }
 
-// ---------- Per-device config routing -------------------------------
+void serviceMqttConfig(ConfigState& cfg, TallyState& tally) {
+    if (s_pendingConfig.empty()) {
+        return;
+    }
+    uint32_t now = millis();
+    if (now - s_lastPendingConfigMs < CONFIG_SETTLE_MS &&
+        now - s_firstPendingConfigMs < CONFIG_MAX_DEFER_MS) {
+        return;   // burst still arriving
+    }
 
-static void handleDeviceConfig(ConfigState& cfg, const String& key, const String& payload) {
-    // key is the part after sanctuary/tally/{device}/config/
-    if (key == "name") {
-        cfg.device.friendlyName = payload;
-    } else if (key == "input") {
-        int v = payload.toInt();
-        if (v >= 0 && v <= 255) {
-            cfg.device.atemInput = static_cast<uint8_t>(v);
+    // Everything about a key (type, range, side effects) comes from its
+    // descriptor, see ConfigSchema.cpp
+    uint8_t  effects   = 0;      // CFG_* flags of the keys accepted
+    uint8_t  changes   = 0;      // ... and of the keys whose value changed
+    bool     anyChange = false;
+    unsigned applied   = 0;
+    for (const PendingConfigKey& p : s_pendingConfig) {
+        ConfigScope scope = p.perDevice ? ConfigScope::Device : ConfigScope::Global;
+        ConfigApplyResult r = configSchema_apply(cfg, scope, p.key, p.payload);
+        if (!r.desc) {
+            Serial.printf("[MQTT] Ignoring unknown config key %s\n", p.key.c_str());
+            continue;
         }
-    } else if (key == "battery_capacity") {
-        int v = payload.toInt();
-        if (v > 0 && v < 100000) {
-            cfg.device.batteryCapacityMah = static_cast<uint16_t>(v);
+        if (!r.accepted) {
+            Serial.printf("[MQTT] Rejected config %s=%s\n", p.key.c_str(), p.payload.c_str());
+            continue;
         }
-    } else if (key == "idle_dim_seconds") {
-        int v = payload.toInt();
-        if (v < 0)      v = 0;
-        if (v > 65535)  v = 65535;
-        cfg.device.idleDimSecondsOverride = static_cast<uint16_t>(v);
-    } else if (key == "log_level") {
-        cfg.device.logLevel = parseLogLevel(payload);
+        applied++;
+        effects |= r.desc->flags;
+        if (r.changed) {
+            changes  |= r.desc->flags;
+            anyChange = true;
+        }
+    }
+    Serial.printf("[MQTT] Applied %u of %u config keys\n",
+                  applied, (unsigned)s_pendingConfig.size());
+    s_pendingConfig.clear();
+
+    // Redelivered retained values change nothing: no SNTP restart
+    if (changes & CFG_TIME) {
+        requestTimeInit();   // debounced in TimeModule
+    }
+    if (changes & CFG_BUS_RULES) {
+        tally.setBusRules(TallyState::parseBusList(cfg.global.tallyProgramBuses),
+                          TallyState::parseBusList(cfg.global.tallyPreviewBuses));
+    }
+    if (changes & CFG_RESTART) {
+        Serial.println("[MQTT] Some config changes take effect after a restart");
+    }
+    if (changes & CFG_PERSIST) {
+        prefs_saveConfig(cfg);
+    }
+    if (anyChange && cfg.global.configEcho) {
+        g_mqtt.publishConfigEcho(configSchema_echo(cfg));
+    }
+
+    // If the per-device input was set via MQTT, sync it into TallyState
+    if (effects & CFG_INPUT) {
+        uint8_t v = cfg.device.atemInput;
+        tally.selectedInput = v;
+        tally.normalizeSelected();
+        Serial.printf("[MQTT] config/input set to %u, publishing status\n", cfg.device.atemInput);
+        g_mqtt.publishSelectedInput(cfg.device.atemInput);
     }
 }
 
@@ -222,30 +581,36 @@ void handleMqttMessage(
     TallyState& tally,
     const String& topic,
     const String& payload,
-    MqttCommand& outCommand
+    CommandQueue& commands
 ) {
-    outCommand.type = MqttCommandType::None;
-
     // 1) ATEM state topics
-    if (topic == TOPIC_ATEM_PREVIEW ||
+    if (topic == TOPIC_ATEM_TALLY ||
+        topic == TOPIC_ATEM_PREVIEW ||
         topic == TOPIC_ATEM_PROGRAM ||
-        topic == TOPIC_ATEM_INPUTS) {
+        topic == TOPIC_ATEM_INPUTS ||
+        topic == TOPIC_ATEM_INPUTS_PATCH ||
+        topic == TOPIC_ATEM_INPUTS_MSGPACK ||
+        topic == TOPIC_ATEM_INPUTS_PATCH_MSGPACK) {
 
-        handleAtemMessage(tally, topic, payload);
+        handleAtemMessage(tally, cfg.global.tallyCoalesceMs, topic, payload);
         return;
     }
 
-    // 2) Global config: sanctuary/tally/config/...
+    // 2) Global config: sanctuary/tally/config (document) or .../config/<key>
+    if (topic == TOPIC_GLOBAL_CONFIG_ROOT) {
+        handleConfigDocument(cfg, false, payload);
+        return;
+    }
     const String globalRoot = String(TOPIC_GLOBAL_CONFIG_ROOT) + "/";
     if (topic.startsWith(globalRoot)) {
         String key = topic.substring(globalRoot.length()); // part after config/
-        handleGlobalConfig(cfg, key, payload);
+        queueConfigKey(false, key, payload);
         return;
     }
 
     // 3) Commands (global / per-device)
     if (topic == TOPIC_ALL_CMD) {
-        outCommand.type = parseCommand(payload);
+        queueCommand(commands, payload);
         return;
     }
 
@@ -255,25 +620,20 @@ void handleMqttMessage(
     // 3a) Per-device command: sanctuary/tally/{device}/cmd
     String devCmd = devRoot + "/cmd";
     if (topic == devCmd) {
-        outCommand.type = parseCommand(payload);
+        queueCommand(commands, payload);
         return;
     }
 
-    // 4) Per-device config: sanctuary/tally/{device}/config/...
+    // 4) Per-device config: sanctuary/tally/{device}/config (document) or
+    //    .../config/<key>
+    if (topic == devRoot + "/config") {
+        handleConfigDocument(cfg, true, payload);
+        return;
+    }
     String devCfgRoot = devRoot + "/config/";
     if (topic.startsWith(devCfgRoot)) {
         String key = topic.substring(devCfgRoot.length()); // part after config/
-        handleDeviceConfig(cfg, key, payload);
-
-        // If the per-device input was changed via MQTT, sync it into TallyState
-        if (key == "input") {
-            uint8_t v = cfg.device.atemInput;
-            tally.selectedInput = v;
-            tally.normalizeSelected();
-            Serial.printf("[MQTT] config/input set to %u, publishing status\n", cfg.device.atemInput);
-            g_mqtt.publishSelectedInput(cfg.device.atemInput);
-        }
-
+        queueConfigKey(true, key, payload);
         return;
     }
 
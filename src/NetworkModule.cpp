@@ -5,8 +5,13 @@
 #include "NetworkModule.h"
 #include "ScreenModule.h"
 #include "MqttClient.h"
+#include "TimeModule.h"
 
 #include <esp_wifi.h>
+#include <esp_netif.h>
+#include <esp_netif_net_stack.h>
+#include <lwip/dhcp.h>
+#include <Preferences.h>
 
 
 extern ConfigState g_config;
@@ -14,11 +19,56 @@ extern MqttClient g_mqtt;
 
 WiFiManager wm;
 millisDelay ms_WiFi;
-Timezone localTime;
-static bool g_timeInitialized = false;
-static bool     g_timeInitRequested     = false;
-static uint32_t g_timeInitRequestedAtMs = 0;
-static constexpr uint32_t TIME_INIT_DEBOUNCE_MS = 2000; // 2s debounce
+
+// --- Fast reconnect cache ------------------------------------
+//
+// Last successful association (BSSID + channel) and IP lease. Kept in RTC
+// memory (survives deep sleep / soft reset) and mirrored to NVS (survives
+// power cycles). On boot we try a direct-channel connect with the cached
+// lease and only fall back to the full scan + DHCP if that fails.
+//
+// The lease is applied as a static config, so it is only reused while the
+// DHCP server still holds it for us: up to T1 (half the lease time) after it
+// was granted. Past that the boot goes straight to DHCP, and a device that
+// is still running on the cached lease hands back to DHCP at T1.
+struct WifiFastCache {
+    uint32_t magic;
+    uint8_t  bssid[6];
+    uint8_t  channel;
+    uint8_t  reserved;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+    uint32_t leaseSec;        // DHCP lease time (T0)
+    uint32_t acquiredEpoch;   // wall-clock time the lease was granted; 0 = unknown
+};
+
+static constexpr uint32_t WIFI_CACHE_MAGIC        = 0x57464332; // "WFC2"
+static constexpr uint32_t FAST_CONNECT_TIMEOUT_MS = 1500;
+static constexpr uint32_t SCAN_CONNECT_TIMEOUT_MS = 10000;
+static constexpr uint32_t DEFAULT_LEASE_SEC       = 3600;       // lease time not reported
+static constexpr uint32_t MAX_STATIC_HOLD_SEC     = 7UL * 24 * 3600;  // millis() headroom
+static const char*        WIFI_CACHE_NAMESPACE    = "wifi_fast";
+static const char*        WIFI_CACHE_KEY          = "cache";
+
+RTC_DATA_ATTR static WifiFastCache s_rtcWifiCache;
+static WifiFastCache      s_nvsWifiCache;            // what NVS currently holds
+static volatile bool      s_wifiCacheDirty = false;  // set from the event task
+
+static volatile bool      s_staticLease    = false;  // running on the cached lease
+static uint32_t           s_staticUntilMs  = 0;      // ... until T1
+static volatile bool      s_leaseEpochPending = false;  // granted before the clock was set
+static volatile uint32_t  s_leaseGotMs     = 0;
+
+static WifiConnectPath    s_connectPath = WifiConnectPath::None;
+static uint32_t           s_connectMs   = 0;
+
+// Boot connect progress (see serviceConnect())
+enum class WifiConnectState : uint8_t { Idle, FastPending, ScanPending, Done };
+static WifiConnectState   s_connectState   = WifiConnectState::Idle;
+static uint32_t           s_connectStartMs = 0;
+static uint32_t           s_scanStartMs    = 0;
 
 
 // Define Functions
@@ -26,10 +76,267 @@ void WiFi_setup();
 void WiFi_onLoop();
 void WiFi_onEvent(WiFiEvent_t event);
 void WiFi_onSaveParams();
+static void serviceConnect();
 
 
 void WiFi_onLoop() {
     if (wm.getWebPortalActive()) wm.process();
+
+    // Config portal runs from the main loop instead of blocking setup()
+    if (wm.getConfigPortalActive()) {
+        wm.process();
+        if (M5.BtnA.wasReleased()) {
+            wm.stopConfigPortal();
+            if (currentScreen == SCREEN_STARTUP) startupLog("Config Portal Stopped...",1);
+        }
+    }
+
+    serviceConnect();
+
+    // Lease granted before the clock was set: back-date it now that it is
+    if (s_leaseEpochPending && time_isSet()) {
+        s_leaseEpochPending = false;
+        s_rtcWifiCache.acquiredEpoch =
+            (uint32_t)time(nullptr) - (millis() - s_leaseGotMs) / 1000;
+        s_wifiCacheDirty = true;
+    }
+
+    // Cached lease reached T1: let DHCP take over (it renews the same
+    // address if the server still has it for us)
+    if (s_staticLease && s_connectState == WifiConnectState::Done &&
+        (int32_t)(millis() - s_staticUntilMs) >= 0) {
+        s_staticLease = false;
+        Serial.println("[WiFi] Cached lease at T1, handing back to DHCP");
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    }
+
+    // Persist a changed association/lease outside the Wi-Fi event task.
+    // Only write NVS when something actually differs (flash wear).
+    if (s_wifiCacheDirty) {
+        s_wifiCacheDirty = false;
+        if (memcmp(&s_rtcWifiCache, &s_nvsWifiCache, sizeof(WifiFastCache)) != 0) {
+            Preferences p;
+            p.begin(WIFI_CACHE_NAMESPACE, false);
+            p.putBytes(WIFI_CACHE_KEY, &s_rtcWifiCache, sizeof(WifiFastCache));
+            p.end();
+            s_nvsWifiCache = s_rtcWifiCache;
+            Serial.println("[WiFi] Fast-connect cache saved to NVS");
+        }
+    }
+}
+
+
+WifiConnectPath WiFi_connectPath() {
+    return s_connectPath;
+}
+
+const char* WiFi_connectPathName() {
+    switch (s_connectPath) {
+        case WifiConnectPath::Fast: return "fast";
+        case WifiConnectPath::Scan: return "scan";
+        case WifiConnectPath::None:
+        default:                    return "none";
+    }
+}
+
+uint32_t WiFi_connectDurationMs() {
+    return s_connectMs;
+}
+
+
+// Lease time the DHCP client was granted (lwIP keeps it, esp_netif doesn't
+// expose it)
+static uint32_t dhcpLeaseSec() {
+    esp_netif_t* nif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    struct netif* lwip = nif ? static_cast<struct netif*>(esp_netif_get_netif_impl(nif)) : nullptr;
+    struct dhcp* dhcp = lwip ? netif_dhcp_data(lwip) : nullptr;
+    if (dhcp && dhcp->offered_t0_lease != 0) {
+        return dhcp->offered_t0_lease;
+    }
+    return DEFAULT_LEASE_SEC;
+}
+
+// Snapshot the current association + lease into the RTC cache (event task).
+static void captureWifiCache() {
+    WifiFastCache c;
+    memset(&c, 0, sizeof(c));
+    c.magic = WIFI_CACHE_MAGIC;
+    const uint8_t* bssid = WiFi.BSSID();
+    if (bssid) memcpy(c.bssid, bssid, sizeof(c.bssid));
+    c.channel = static_cast<uint8_t>(WiFi.channel());
+    c.ip      = static_cast<uint32_t>(WiFi.localIP());
+    c.gateway = static_cast<uint32_t>(WiFi.gatewayIP());
+    c.subnet  = static_cast<uint32_t>(WiFi.subnetMask());
+    c.dns     = static_cast<uint32_t>(WiFi.dnsIP(0));
+
+    if (s_staticLease) {
+        // Our own static config, not a new grant: keep aging the old lease
+        c.leaseSec      = s_rtcWifiCache.leaseSec;
+        c.acquiredEpoch = s_rtcWifiCache.acquiredEpoch;
+    } else {
+        c.leaseSec = dhcpLeaseSec();
+        if (time_isSet()) {
+            c.acquiredEpoch = (uint32_t)time(nullptr);
+        } else {
+            s_leaseGotMs        = millis();
+            s_leaseEpochPending = true;
+        }
+    }
+
+    if (memcmp(&c, &s_rtcWifiCache, sizeof(c)) != 0) {
+        s_rtcWifiCache = c;
+    }
+    s_wifiCacheDirty = true;
+}
+
+// Load the cache (RTC first, then NVS). Returns false if nothing usable.
+static bool loadWifiCache(WifiFastCache& out) {
+    Preferences p;
+    p.begin(WIFI_CACHE_NAMESPACE, true);
+    size_t len = p.getBytes(WIFI_CACHE_KEY, &s_nvsWifiCache, sizeof(WifiFastCache));
+    p.end();
+    if (len != sizeof(WifiFastCache)) {
+        memset(&s_nvsWifiCache, 0, sizeof(WifiFastCache));
+    }
+
+    if (s_rtcWifiCache.magic == WIFI_CACHE_MAGIC) {
+        out = s_rtcWifiCache;
+    } else if (s_nvsWifiCache.magic == WIFI_CACHE_MAGIC) {
+        out = s_nvsWifiCache;
+    } else {
+        return false;
+    }
+    return out.channel != 0 && out.ip != 0;
+}
+
+// Seconds the cached lease can still be used as a static config (until T1);
+// 0 if it has expired or its age is unknown.
+static uint32_t leaseSecondsLeft(const WifiFastCache& c) {
+    if (!time_isSet() || c.acquiredEpoch == 0 || c.leaseSec == 0) {
+        return 0;
+    }
+    uint64_t t1  = (uint64_t)c.acquiredEpoch + c.leaseSec / 2;
+    uint64_t now = (uint64_t)time(nullptr);
+    if (now < c.acquiredEpoch || now >= t1) {
+        return 0;
+    }
+    uint64_t left = t1 - now;
+    return left > MAX_STATIC_HOLD_SEC ? MAX_STATIC_HOLD_SEC : (uint32_t)left;
+}
+
+// Start a direct-channel connect to the cached BSSID with the cached static
+// lease. Returns false if there is nothing usable to try.
+static bool startFastConnect() {
+    WifiFastCache c;
+    if (!loadWifiCache(c)) {
+        return false;
+    }
+
+    uint32_t leftSec = leaseSecondsLeft(c);
+    if (leftSec == 0) {
+        Serial.println("[WiFi] Cached lease expired or undated, using DHCP");
+        return false;
+    }
+
+    String ssid = wm.getWiFiSSID(true);
+    String pass = wm.getWiFiPass(true);
+    if (!ssid.length()) {
+        return false;   // never provisioned; startScanConnect() opens the portal
+    }
+
+    Serial.printf("[WiFi] Fast connect: ch=%u bssid=%02X:%02X:%02X:%02X:%02X:%02X ip=%s\n",
+                  c.channel, c.bssid[0], c.bssid[1], c.bssid[2], c.bssid[3], c.bssid[4], c.bssid[5],
+                  IPAddress(c.ip).toString().c_str());
+
+    s_staticLease   = true;
+    s_staticUntilMs = millis() + leftSec * 1000;
+    WiFi.config(IPAddress(c.ip), IPAddress(c.gateway), IPAddress(c.subnet), IPAddress(c.dns));
+    WiFi.begin(ssid.c_str(), pass.c_str(), c.channel, c.bssid, true);
+    return true;
+}
+
+// Fast path connected: don't pin later auto-reconnects to this BSSID/channel
+// (AP handoff).
+static void releaseFastConnectPin() {
+    wifi_config_t conf;
+    if (esp_wifi_get_config(WIFI_IF_STA, &conf) == ESP_OK) {
+        conf.sta.bssid_set = 0;
+        conf.sta.channel   = 0;
+        esp_wifi_set_config(WIFI_IF_STA, &conf);
+    }
+}
+
+// No AP could be joined (or none provisioned): open the config portal.
+// It is non-blocking; WiFi_onLoop() services it.
+static void startConfigPortal() {
+    const auto eff = g_config.effective();
+    String hostname = eff.deviceName.length() ? eff.deviceName : eff.deviceId;
+
+    wm.startConfigPortal(hostname.c_str());
+    if (currentScreen == SCREEN_STARTUP) {
+        startupLog("No access point found!",1);
+        startupLog("Config Portal Started.\r\nPress M5 to abort.",1);
+    }
+}
+
+// Full scan + DHCP with the credentials WiFiManager saved. Returns
+// immediately; serviceConnect() polls for the result.
+static void startScanConnect() {
+    String ssid = wm.getWiFiSSID(true);
+    String pass = wm.getWiFiPass(true);
+    if (!ssid.length()) {
+        s_connectState = WifiConnectState::Done;
+        startConfigPortal();
+        return;
+    }
+
+    WiFi.begin(ssid.c_str(), pass.c_str());
+    s_scanStartMs  = millis();
+    s_connectState = WifiConnectState::ScanPending;
+}
+
+// Advance the boot connect: fast attempt -> (timeout) -> full scan ->
+// (timeout) -> config portal.
+static void serviceConnect() {
+    if (s_connectState == WifiConnectState::ScanPending) {
+        if (WiFi.status() == WL_CONNECTED) {
+            s_connectState = WifiConnectState::Done;
+            s_connectPath  = WifiConnectPath::Scan;
+            s_connectMs    = millis() - s_connectStartMs;
+            Serial.printf("[WiFi] Connected via full scan in %lu ms\n", (unsigned long)s_connectMs);
+        } else if (millis() - s_scanStartMs >= SCAN_CONNECT_TIMEOUT_MS) {
+            Serial.println("[WiFi] Full scan connect timed out");
+            s_connectState = WifiConnectState::Done;
+            startConfigPortal();
+        }
+        return;
+    }
+
+    if (s_connectState != WifiConnectState::FastPending) {
+        return;
+    }
+
+    if (WiFi.status() == WL_CONNECTED) {
+        releaseFastConnectPin();
+        s_connectState = WifiConnectState::Done;
+        s_connectPath  = WifiConnectPath::Fast;
+        s_connectMs    = millis() - s_connectStartMs;
+        Serial.printf("[WiFi] Connected via fast path in %lu ms\n", (unsigned long)s_connectMs);
+        return;
+    }
+
+    if (millis() - s_connectStartMs < FAST_CONNECT_TIMEOUT_MS) {
+        return;
+    }
+
+    // AP moved / changed channel / lease gone: forget the RTC copy, back to DHCP
+    Serial.println("[WiFi] Fast connect failed, falling back to full scan");
+    s_rtcWifiCache.magic = 0;
+    s_staticLease = false;
+    WiFi.disconnect();
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+
+    startScanConnect();
 }
 
 
@@ -38,6 +345,7 @@ void WiFi_setup () {
     const auto eff = g_config.effective();
     String hostname = eff.deviceName.length() ? eff.deviceName : eff.deviceId;
 
+    WiFi.setHostname(hostname.c_str());             // before the STA interface starts
     WiFi.mode(WIFI_STA);
     WiFi.onEvent(WiFi_onEvent);
     WiFi.setScanMethod(WIFI_ALL_CHANNEL_SCAN);
@@ -109,114 +417,18 @@ void WiFi_setup () {
     wm.setHostname(hostname.c_str());
     wm.setWiFiAutoReconnect(true);
     wm.setRemoveDuplicateAPs(false);
-    
-    if (!wm.autoConnect(hostname.c_str())) {
-        if (currentScreen == SCREEN_STARTUP) {
-            startupLog("No access point found!",1);
-            startupLog("Config Portal Started.\r\nPress M5 to abort.",1);
-        }
-        while (wm.getConfigPortalActive()) {
-            wm.process();
-            M5.update();
-            if (M5.BtnA.wasReleased()) wm.stopConfigPortal();
-        }
-        if (currentScreen == SCREEN_STARTUP) startupLog("Config Portal Stopped...",1);
-        //ESP.restart();
-    }
-    
-}
 
-// Internal helper: perform RTC/NTP initialization once per boot.
-static void doTimeInitOnce() {
-    if (g_timeInitialized) {
-        return;
-    }
+    wm.setConnectTimeout(10);                       // bound the portal's connect attempt
 
-    // Require MQTT connection before initializing time
-    if (!g_mqtt.isConnected()) {
-        Serial.println("[net] doTimeInitOnce: MQTT not connected, aborting.");
-        return;
-    }
-
-    if (WiFi.status() != WL_CONNECTED) {
-        Serial.println("[net] doTimeInitOnce: WiFi not connected, aborting.");
-        if (currentScreen == SCREEN_STARTUP) {
-            startupLog("ezTime init: WiFi not connected", 1);
-        }
-        return;
-    }
-
-    if (currentScreen == SCREEN_STARTUP) {
-        startupLog("Initializing ezTime...", 1);
-    }
-
-    // Use global config strings so ezTime doesn't hold pointers into temporaries.
-    const String& ntpServer = g_config.global.ntpServer;
-    const String& tz        = g_config.global.timeZone;
-
-    Serial.println("[net] NTP Server: " + String(ntpServer));
-    Serial.println("[net] Timezone: " + String(tz));
-
-    if (!localTime.setCache("timezone", "localTime")) {
-        localTime.setLocation(tz.c_str());
-    }
-    localTime.setDefault();
-
-    setServer(ntpServer.c_str());
-
-    waitForSync(15);
-    if (timeStatus() == timeSet) {
-        g_timeInitialized = true;
-        g_config.device.ntp_isSynchronized = true;
-        Serial.println("UTC Time: " + UTC.dateTime(ISO8601));
-        Serial.println("Local Time: " + localTime.dateTime(ISO8601));
-        constexpr size_t BUFF_MAX_LEN   = 65;
-        char buff[BUFF_MAX_LEN];
-        snprintf(buff, sizeof(buff), "Local Time: %s", localTime.dateTime(ISO8601).c_str());
-        if (currentScreen == SCREEN_STARTUP) {
-            startupLog(buff, 1);
-        }
+    // Non-blocking: WiFi_onLoop() finishes the connect (or runs the portal)
+    s_connectStartMs = millis();
+    if (startFastConnect()) {
+        s_connectState = WifiConnectState::FastPending;
     } else {
-        Serial.println("[net] ezTime initialization failed...");
-        if (currentScreen == SCREEN_STARTUP) {
-            startupLog("ezTime initialization failed...", 1);
-        }
+        startScanConnect();
     }
 }
 
-void requestTimeInit() {
-    g_timeInitRequested     = true;
-    g_timeInitRequestedAtMs = millis();
-}
-
-void requestTimeResync() {
-    // Allow a future NTP sync even if we already initialized once
-    g_timeInitialized = false;
-    g_config.device.ntp_isSynchronized = false;
-    requestTimeInit();
-}
-
-void serviceTimeInit() {
-    if (!g_timeInitRequested || g_timeInitialized) {
-        return;
-    }
-
-    uint32_t now = millis();
-    if (now - g_timeInitRequestedAtMs < TIME_INIT_DEBOUNCE_MS) {
-        return; // still debouncing
-    }
-
-    // Don’t clear the request until network is actually ready
-    if (!g_mqtt.isConnected() || WiFi.status() != WL_CONNECTED) {
-        return; // keep g_timeInitRequested = true; we'll try again next loop
-    }
-
-    // Network is ready and debounce interval has passed: do one-time init
-    g_timeInitRequested = false;
-    doTimeInitOnce();
-}
-
-
 void WiFi_onEvent(WiFiEvent_t event) {
   
   //Serial.printf("[WiFi-event] event: %d\n", event);
@@ -254,6 +466,7 @@ void WiFi_onEvent(WiFiEvent_t event) {
       case ARDUINO_EVENT_WIFI_STA_GOT_IP:
           Serial.print(F("Obtained IP address: "));
           Serial.println(WiFi.localIP());
+          captureWifiCache();
           if (currentScreen == SCREEN_STARTUP) {
             char buff[65];
             snprintf(buff, sizeof(buff), "Obtained IP address: %s", WiFi.localIP().toString().c_str());
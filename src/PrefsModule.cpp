@@ -1,7 +1,10 @@
 #include <WiFiManager.h>
 
 #include <Preferences.h>
+#include <millisDelay.h>
+#include <time.h>
 #include "PrefsModule.h"
+#include "ConfigSchema.h"
 #include "NetworkModule.h"
 
 
@@ -75,4 +78,242 @@ void prefs_applyToConfig(ConfigState& cfg) {
     cfg.global.mqttPort   = mqtt_port;  // Mosquitto default
     cfg.global.mqttUsername = String(mqtt_username);
     cfg.global.mqttPassword = String(mqtt_password);
-}
\ No newline at end of file
+}
+
+
+// --- Persisted config keys ---------------------------------------------------
+
+static const char* CONFIG_NAMESPACE = "config";
+
+// NVS keys are limited to 15 characters, so store by scope + name hash
+static void configNvsKey(const ConfigKeyDesc& d, char (&out)[12]) {
+    snprintf(out, sizeof(out), "%c%08lx", d.scope == ConfigScope::Device ? 'd' : 'g',
+             (unsigned long)d.hash);
+}
+
+void prefs_loadConfig(ConfigState& cfg) {
+    size_t count;
+    const ConfigKeyDesc* keys = configSchema_table(count);
+    unsigned loaded = 0;
+
+    preferences.begin(CONFIG_NAMESPACE, true);
+    for (size_t i = 0; i < count; ++i) {
+        if (!(keys[i].flags & CFG_PERSIST)) continue;
+        char key[12];
+        configNvsKey(keys[i], key);
+        if (!preferences.isKey(key)) continue;
+        if (configSchema_set(cfg, keys[i], preferences.getString(key)).accepted) {
+            loaded++;
+        }
+    }
+    preferences.end();
+
+    Serial.printf("[prefs] restored %u config keys\n", loaded);
+}
+
+void prefs_saveConfig(const ConfigState& cfg) {
+    size_t count;
+    const ConfigKeyDesc* keys = configSchema_table(count);
+    unsigned written = 0;
+
+    preferences.begin(CONFIG_NAMESPACE, false);
+    for (size_t i = 0; i < count; ++i) {
+        if (!(keys[i].flags & CFG_PERSIST)) continue;
+        char key[12];
+        configNvsKey(keys[i], key);
+        String value = configSchema_format(cfg, keys[i]);
+        if (preferences.isKey(key) && preferences.getString(key) == value) continue;
+        preferences.putString(key, value);
+        written++;
+    }
+    preferences.end();
+
+    Serial.printf("[prefs] saved %u config keys\n", written);
+}
+
+
+// --- Warm-start tally cache --------------------------------------------------
+//
+// The input table, selection and friendly name change rarely and go to NVS.
+// Program/preview change on every cut, so they live in RTC memory (survives
+// reboot and deep sleep) and only ride along in NVS when the table is
+// rewritten anyway; that keeps flash writes off the per-cut path.
+
+static const char*    TALLY_CACHE_NAMESPACE = "tally_cache";
+static const char*    TALLY_CACHE_KEY       = "snap";
+static const uint8_t  TALLY_CACHE_VERSION   = 1;
+static const uint8_t  TALLY_CACHE_MAX_INPUTS = 32;
+static const uint32_t TALLY_CACHE_CHECK_MS  = 1000;
+static const uint32_t TALLY_RTC_MAGIC       = 0x54414C59; // "TALY"
+
+constexpr size_t SNAP_FRIENDLY_LEN = 24;
+constexpr size_t SNAP_SHORT_LEN    = 8;
+constexpr size_t SNAP_LONG_LEN     = 32;
+
+struct TallySnapshotHeader {
+    uint8_t  version;
+    uint8_t  count;
+    uint8_t  selected;
+    uint8_t  program;
+    uint8_t  preview;
+    uint8_t  reserved[3];
+    uint32_t savedEpoch;
+    char     friendlyName[SNAP_FRIENDLY_LEN];
+};
+
+struct TallySnapshotEntry {
+    uint8_t id;
+    uint8_t tallyEnabled;
+    char    shortName[SNAP_SHORT_LEN];
+    char    longName[SNAP_LONG_LEN];
+};
+
+struct TallySnapshot {
+    TallySnapshotHeader hdr;
+    TallySnapshotEntry  entries[TALLY_CACHE_MAX_INPUTS];
+};
+
+struct TallyRtcState {
+    uint32_t magic;
+    uint8_t  program;
+    uint8_t  preview;
+    uint32_t savedEpoch;
+};
+
+RTC_DATA_ATTR static TallyRtcState s_tallyRtc;
+
+static TallySnapshot s_snapshot;             // scratch buffer (no heap)
+static uint32_t      s_lastTableHash = 0;    // hash of what NVS holds
+static millisDelay   md_tallyCache;
+
+static uint32_t fnv1a(const uint8_t* data, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ data[i]) * 16777619u;
+    }
+    return h;
+}
+
+static uint32_t epochNowOrZero() {
+    time_t now = time(nullptr);
+    return (now > 1600000000) ? static_cast<uint32_t>(now) : 0;
+}
+
+static size_t snapshotSize(uint8_t count) {
+    return sizeof(TallySnapshotHeader) + count * sizeof(TallySnapshotEntry);
+}
+
+// Hash of the slow-changing part (table, selection, name)
+static uint32_t tableHash(const TallySnapshot& snap) {
+    TallySnapshotHeader h = snap.hdr;
+    h.program = 0;
+    h.preview = 0;
+    h.savedEpoch = 0;
+    uint32_t a = fnv1a(reinterpret_cast<const uint8_t*>(&h), sizeof(h));
+    uint32_t b = fnv1a(reinterpret_cast<const uint8_t*>(snap.entries), snap.hdr.count * sizeof(TallySnapshotEntry));
+    return a ^ (b * 31u);
+}
+
+static void buildSnapshot(const TallyState& tally, const ConfigState& cfg, TallySnapshot& snap) {
+    memset(&snap, 0, sizeof(snap));
+    snap.hdr.version  = TALLY_CACHE_VERSION;
+    snap.hdr.selected = tally.selectedInput;
+    snap.hdr.program  = tally.programInput;
+    snap.hdr.preview  = tally.previewInput;
+    snap.hdr.savedEpoch = epochNowOrZero();
+    strlcpy(snap.hdr.friendlyName, cfg.device.friendlyName.c_str(), sizeof(snap.hdr.friendlyName));
+
+    uint8_t n = 0;
+    for (const auto& kv : tally.inputs) {
+        if (n >= TALLY_CACHE_MAX_INPUTS) break;
+        TallySnapshotEntry& e = snap.entries[n++];
+        e.id           = kv.first;
+        e.tallyEnabled = kv.second.tallyEnabled ? 1 : 0;
+        strlcpy(e.shortName, kv.second.shortName.c_str(), sizeof(e.shortName));
+        strlcpy(e.longName,  kv.second.longName.c_str(),  sizeof(e.longName));
+    }
+    snap.hdr.count = n;
+}
+
+bool prefs_restoreTallySnapshot(TallyState& tally, ConfigState& cfg) {
+    Preferences p;
+    p.begin(TALLY_CACHE_NAMESPACE, true);
+    size_t len = p.getBytes(TALLY_CACHE_KEY, &s_snapshot, sizeof(s_snapshot));
+    p.end();
+
+    if (len < sizeof(TallySnapshotHeader) ||
+        s_snapshot.hdr.version != TALLY_CACHE_VERSION ||
+        s_snapshot.hdr.count > TALLY_CACHE_MAX_INPUTS ||
+        len != snapshotSize(s_snapshot.hdr.count)) {
+        return false;
+    }
+    s_lastTableHash = tableHash(s_snapshot);
+
+    tally.inputs.clear();
+    for (uint8_t i = 0; i < s_snapshot.hdr.count; i++) {
+        const TallySnapshotEntry& e = s_snapshot.entries[i];
+        AtemInputInfo info;
+        info.id           = e.id;
+        info.tallyEnabled = e.tallyEnabled != 0;
+        info.shortName    = String(e.shortName);
+        info.longName     = String(e.longName);
+        tally.inputs[e.id] = info;
+    }
+
+    // Prefer the RTC copy of program/preview (newer than the NVS one)
+    if (s_tallyRtc.magic == TALLY_RTC_MAGIC) {
+        tally.setProgramInput(s_tallyRtc.program);
+        tally.setPreviewInput(s_tallyRtc.preview);
+        tally.restoredEpoch = s_tallyRtc.savedEpoch;
+    } else {
+        tally.setProgramInput(s_snapshot.hdr.program);
+        tally.setPreviewInput(s_snapshot.hdr.preview);
+        tally.restoredEpoch = s_snapshot.hdr.savedEpoch;
+    }
+    tally.stale = true;   // until MQTT confirms program + preview
+
+    tally.selectedInput = s_snapshot.hdr.selected;
+    tally.normalizeSelected();
+    cfg.device.atemInput = tally.selectedInput;
+    if (s_snapshot.hdr.friendlyName[0] != '\0') {
+        cfg.device.friendlyName = String(s_snapshot.hdr.friendlyName);
+    }
+
+    Serial.printf("[prefs] Warm start: %u inputs, sel=%u pgm=%u pvw=%u\n",
+                  s_snapshot.hdr.count, tally.selectedInput, tally.programInput, tally.previewInput);
+    return true;
+}
+
+void prefs_serviceTallySnapshot(const TallyState& tally, const ConfigState& cfg) {
+    if (!md_tallyCache.isRunning()) {
+        md_tallyCache.start(TALLY_CACHE_CHECK_MS);
+        return;
+    }
+    if (!md_tallyCache.justFinished()) return;
+    md_tallyCache.repeat();
+
+    // Nothing live yet: don't overwrite a good cache with an empty table
+    if (tally.stale || tally.inputs.empty()) return;
+
+    // Program/preview: RAM-speed RTC update on every change
+    if (s_tallyRtc.magic != TALLY_RTC_MAGIC ||
+        s_tallyRtc.program != tally.programInput ||
+        s_tallyRtc.preview != tally.previewInput) {
+        s_tallyRtc.magic      = TALLY_RTC_MAGIC;
+        s_tallyRtc.program    = tally.programInput;
+        s_tallyRtc.preview    = tally.previewInput;
+        s_tallyRtc.savedEpoch = epochNowOrZero();
+    }
+
+    // Table/selection/name: NVS only when the content actually changed
+    buildSnapshot(tally, cfg, s_snapshot);
+    uint32_t h = tableHash(s_snapshot);
+    if (h == s_lastTableHash) return;
+
+    Preferences p;
+    p.begin(TALLY_CACHE_NAMESPACE, false);
+    p.putBytes(TALLY_CACHE_KEY, &s_snapshot, snapshotSize(s_snapshot.hdr.count));
+    p.end();
+    s_lastTableHash = h;
+    Serial.printf("[prefs] Tally snapshot saved (%u inputs)\n", s_snapshot.hdr.count);
+}
@@ -0,0 +1,196 @@
+#include "PublishQueue.h"
+
+// Indexed by PubTopic
+static const PubTopicDesc PUB_TOPICS[] = {
+    // subtopic                         debounce prio retain suppressRepeat
+    { "availability",                      0,    0,  true,  false },
+    { "status/tally",                    100,    1,  false, true  },
+    { "status/input",                    150,    1,  false, true  },
+    { "status/short_name",               150,    2,  false, true  },
+    { "status/long_name",                150,    2,  false, true  },
+    // Periodic status: always sent (not retained, so it doubles as heartbeat)
+    { "status/uptime",                     0,    3,  false, false },
+    { "status/battery_mv",                 0,    3,  false, false },
+    { "status/battery_pct",                0,    3,  false, false },
+    { "status/battery_pct_coulomb",        0,    3,  false, false },
+    { "status/battery_pct_hybrid",         0,    3,  false, false },
+    { "status/coulomb_count",              0,    3,  false, false },
+    { "status/rssi",                       0,    3,  false, false },
+    { "status/wifi_connect_path",          0,    3,  false, false },
+    { "status/wifi_connect_ms",            0,    3,  false, false },
+    { "status/temperature",                0,    3,  false, false },
+    { "status/boot_to_tally_ms",           0,    3,  false, false },
+    { "status/display_blocked_us",         0,    3,  false, false },
+    { "status/loop_max_ms",                0,    3,  false, false },
+    { "status/mqtt_blocked_us",            0,    3,  false, false },
+    { "status/mqtt_rx_dropped",            0,    3,  false, false },
+    { "status/mqtt_recover_ms",            0,    3,  false, false },
+    { "status/mqtt_recover_attempts",      0,    3,  false, false },
+    { "status/mqtt_replayed",              0,    3,  false, false },
+    { "status/mqtt_dropped",               0,    3,  false, false },
+    { "status/tally_coalesced",            0,    3,  false, false },
+    { "status/tally_coalesce_timeouts",    0,    3,  false, false },
+    { "status/udp_tally_rx",               0,    3,  false, false },
+    { "status/udp_tally_rejected",         0,    3,  false, false },
+    { "status/atem_link",                  0,    3,  false, false },
+    { "status/atem_resends",               0,    3,  false, false },
+    { "status/tsl_rx",                     0,    3,  false, false },
+    { "status/tsl_rejected",               0,    3,  false, false },
+    { "status/restarts",                   0,    3,  false, false },
+    { "status/firmware_version",           0,    3,  false, false },
+    { "status/buildDateTime",              0,    3,  false, false },
+    { "status/hw_revision",                0,    3,  false, false },
+    // All of the above in one document (status_encoding json/msgpack)
+    { "status/batch",                      0,    3,  false, false },
+    // Applied config (config_echo), only when it changed
+    { "status/config",                     0,    3,  false, true  },
+};
+static_assert(sizeof(PUB_TOPICS) / sizeof(PUB_TOPICS[0]) == static_cast<size_t>(PubTopic::Count_),
+              "PUB_TOPICS must match PubTopic");
+
+// Event streams: subtopic and priority (same scale as PUB_TOPICS)
+static const char*   STREAM_SUBTOPIC[] = { "status/log", "cmd/ack" };
+static const uint8_t STREAM_PRIORITY[] = { 3, 1 };
+
+const PubTopicDesc& PublishQueue::describe(PubTopic t) {
+    return PUB_TOPICS[static_cast<size_t>(t)];
+}
+
+void PublishQueue::set(PubTopic t, const String& value) {
+    const PubTopicDesc& d = describe(t);
+    Slot& s = _slots[static_cast<size_t>(t)];
+
+    // Back to what the broker already has: nothing to send
+    if (d.suppressRepeat && s.everSent && value == s.lastSent) {
+        if (s.pending) {
+            s.pending = false;
+            _pendingCount--;
+        }
+        _suppressed++;
+        return;
+    }
+
+    if (!s.pending) {
+        s.pending = true;
+        _pendingCount++;
+    } else if (!_online) {
+        _dropped++;     // keep-latest: the older offline value is gone
+    }
+    s.value       = value;
+    s.changedAtMs = millis();
+    s.offline     = !_online;
+}
+
+void PublishQueue::push(PubStream stream, const char* text) {
+    if (_streamCount == STREAM_CAPACITY) {
+        // FIFO, drop oldest: the most recent history is the useful part
+        _streamHead = (_streamHead + 1) % STREAM_CAPACITY;
+        _streamCount--;
+        _dropped++;
+    }
+
+    StreamEntry& e = _stream[(_streamHead + _streamCount) % STREAM_CAPACITY];
+    size_t len = strlen(text);
+    if (len > STREAM_TEXT_MAX) len = STREAM_TEXT_MAX;
+    memcpy(e.text, text, len);
+    e.text[len] = '\0';
+    e.len     = static_cast<uint8_t>(len);
+    e.atMs    = millis();
+    e.stream  = stream;
+    e.offline = !_online;
+    _streamCount++;
+}
+
+// Send the oldest stream entry. Log lines queued while offline get their
+// age prepended, since they arrive late.
+bool PublishQueue::publishStreamHead(uint32_t nowMs, const PublishFn& publish) {
+    if (_streamCount == 0) {
+        return false;
+    }
+    const StreamEntry& e = _stream[_streamHead];
+    const uint8_t idx = static_cast<uint8_t>(e.stream);
+
+    if (e.offline && e.stream == PubStream::Log) {
+        char buf[STREAM_TEXT_MAX + 24];
+        snprintf(buf, sizeof(buf), "[-%lus] %s",
+                 (unsigned long)((nowMs - e.atMs) / 1000), e.text);
+        publish(STREAM_SUBTOPIC[idx], String(buf), false);
+    } else {
+        publish(STREAM_SUBTOPIC[idx], String(e.text), false);
+    }
+    if (e.offline) {
+        _replayed++;
+    }
+
+    _streamHead = (_streamHead + 1) % STREAM_CAPACITY;
+    _streamCount--;
+    return true;
+}
+
+void PublishQueue::drain(uint32_t nowMs, uint16_t ratePerSec, const PublishFn& publish) {
+    if (ratePerSec == 0) ratePerSec = 1;
+
+    // Refill: ratePerSec messages per second, at most one second's worth banked
+    const uint32_t capMilli = (uint32_t)ratePerSec * 1000UL;
+    uint32_t elapsed = nowMs - _lastRefillMs;
+    _lastRefillMs = nowMs;
+    if (elapsed > 1000) elapsed = 1000;
+    _tokensMilli += elapsed * ratePerSec;
+    if (_tokensMilli > capMilli) _tokensMilli = capMilli;
+
+    while ((_pendingCount > 0 || _streamCount > 0) && _tokensMilli >= 1000) {
+        // Most urgent due topic (lowest priority value, then table order)
+        int best = -1;
+        for (size_t i = 0; i < static_cast<size_t>(PubTopic::Count_); ++i) {
+            const Slot& s = _slots[i];
+            if (!s.pending) continue;
+            if (nowMs - s.changedAtMs < PUB_TOPICS[i].debounceMs) continue;
+            if (best < 0 || PUB_TOPICS[i].priority < PUB_TOPICS[best].priority) {
+                best = static_cast<int>(i);
+            }
+        }
+
+        // Oldest stream entry competes on priority; state wins ties
+        if (_streamCount > 0) {
+            const uint8_t streamPrio = STREAM_PRIORITY[static_cast<uint8_t>(_stream[_streamHead].stream)];
+            if (best < 0 || streamPrio < PUB_TOPICS[best].priority) {
+                publishStreamHead(nowMs, publish);
+                _tokensMilli -= 1000;
+                continue;
+            }
+        }
+        if (best < 0) {
+            return;   // everything pending is still debouncing
+        }
+
+        Slot& s = _slots[best];
+        const PubTopicDesc& d = PUB_TOPICS[best];
+        publish(d.subtopic, s.value, d.retain);
+        if (s.offline) {
+            _replayed++;
+            s.offline = false;
+        }
+
+        s.lastSent = s.value;
+        s.everSent = true;
+        s.pending  = false;
+        _pendingCount--;
+        _tokensMilli -= 1000;
+    }
+}
+
+void PublishQueue::forgetSent() {
+    const uint32_t now = millis();
+    for (size_t i = 0; i < static_cast<size_t>(PubTopic::Count_); ++i) {
+        Slot& s = _slots[i];
+        const PubTopicDesc& d = PUB_TOPICS[i];
+        // Not pending: value is what was last sent. Pending: the newer
+        // value goes out anyway.
+        if (s.everSent && (d.retain || d.suppressRepeat) && !s.pending) {
+            s.pending     = true;
+            s.changedAtMs = now;
+            _pendingCount++;
+        }
+        s.everSent = false;
+    }
+}
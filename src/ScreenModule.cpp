@@ -2,8 +2,10 @@
 #include <millisDelay.h>
 
 #include "NetworkModule.h"
+#include "TimeModule.h"
 #include "PowerModule.h"
 #include "ScreenModule.h"
+#include "DisplayModule.h"
 
 #include "ConfigState.h"
 #include "TallyState.h"
@@ -42,15 +44,89 @@ startupLogData startupLogEntries[20];
 int index_startupLog = -1;
 
 
+// The tally screen is a 4-bit palette sprite (~16 KB instead of ~64 KB for
+// RGB565). Draw calls take palette indices; pixels are only expanded to
+// RGB565 when the sprite is pushed to the panel.
+static const uint8_t PAL_BLACK    = 0;
+static const uint8_t PAL_WHITE    = 1;
+static const uint8_t PAL_DARKGREY = 2;
+static const uint8_t PAL_PROGRAM  = 3;   // from tallyColorProgram
+static const uint8_t PAL_PREVIEW  = 4;   // from tallyColorPreview
+static const uint8_t PAL_BAT_LOW  = 5;   // battery fill <= 20%
+static const uint8_t PAL_BAT_OK   = 6;   // battery fill > 20%
+static const uint8_t PAL_PROGRAM_STALE = 7;   // dimmed program (warm-start cache, unconfirmed)
+static const uint8_t PAL_PREVIEW_STALE = 8;   // dimmed preview (warm-start cache, unconfirmed)
+
+static const uint8_t TALLY_COLOR_DEPTH = 4;
+
+// Last colors written into the palette, so we only touch it on change
+static String appliedColorProgram;
+static String appliedColorPreview;
+
+// Parse "#RRGGBB" (or "RRGGBB") into 0xRRGGBB; returns fallback on bad input.
+static uint32_t parseHexColor(const String& in, uint32_t fallback) {
+    const char* s = in.c_str();
+    if (*s == '#') s++;
+    if (strlen(s) != 6) return fallback;
+
+    char* end = nullptr;
+    uint32_t v = strtoul(s, &end, 16);
+    if (end == nullptr || *end != '\0') return fallback;
+    return v;
+}
+
+// Same hue at ~40% intensity, for unconfirmed (stale) tally state.
+static uint32_t dimColor(uint32_t rgb) {
+    uint32_t r = ((rgb >> 16) & 0xFF) * 2 / 5;
+    uint32_t g = ((rgb >> 8) & 0xFF) * 2 / 5;
+    uint32_t b = (rgb & 0xFF) * 2 / 5;
+    return (r << 16) | (g << 8) | b;
+}
+
+static void setPaletteRgb(uint8_t index, uint32_t rgb) {
+    tallyScreen.setPaletteColor(index, (rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF);
+}
+
+// Load fixed UI colors plus the configured program/preview colors.
+static void initTallyPalette() {
+    setPaletteRgb(PAL_BLACK,    0x000000);
+    setPaletteRgb(PAL_WHITE,    0xFFFFFF);
+    setPaletteRgb(PAL_DARKGREY, 0x808080);
+    setPaletteRgb(PAL_BAT_LOW,  0x960000);
+    setPaletteRgb(PAL_BAT_OK,   0x007800);
+    appliedColorProgram = "";
+    appliedColorPreview = "";
+}
+
+// Swap program/preview palette entries if the configured colors changed.
+static void applyTallyPalette(const EffectiveConfig& eff) {
+    if (eff.tallyColorProgram != appliedColorProgram) {
+        uint32_t rgb = parseHexColor(eff.tallyColorProgram, 0xFF0000);
+        setPaletteRgb(PAL_PROGRAM, rgb);
+        setPaletteRgb(PAL_PROGRAM_STALE, dimColor(rgb));
+        appliedColorProgram = eff.tallyColorProgram;
+    }
+    if (eff.tallyColorPreview != appliedColorPreview) {
+        uint32_t rgb = parseHexColor(eff.tallyColorPreview, 0x00FF00);
+        setPaletteRgb(PAL_PREVIEW, rgb);
+        setPaletteRgb(PAL_PREVIEW_STALE, dimColor(rgb));
+        appliedColorPreview = eff.tallyColorPreview;
+    }
+}
+
+
 
 void refreshTallyScreen() {
 
     // EffectiveConfig merges global + device config
     const auto eff = g_config.effective();
 
+    // Configured tally colors are a palette swap, not a redraw
+    applyTallyPalette(eff);
+
     // Black strip across the top to keep status elements readable
     const int statusBarHeight = 50;  // taller bar for two rows of info
-    tallyScreen.fillRect(0, 0, tft_width, statusBarHeight, TFT_BLACK);
+    tallyScreen.fillRect(0, 0, tft_width, statusBarHeight, PAL_BLACK);
 
     // Use smallest FreeSans font for the status bar
     tallyScreen.setFont(&fonts::DejaVu12);
@@ -79,9 +155,20 @@ void refreshTallyScreen() {
     int batCenterX    = 7 * segWidth8;
 
     // Clock (first segment, centered, on the top row)
-    auto now = localTime.dateTime("g:i:s A");
-    String timeStr = now ? String(now) : String("--:--:--");
-    tallyScreen.setTextColor(TFT_WHITE, TFT_BLACK);
+    char clockBuf[16];
+    String timeStr = time_formatClock(clockBuf, sizeof(clockBuf)) ? String(clockBuf)
+                                                                   : String("--:--:--");
+
+    // Warm-start state not yet confirmed by MQTT: say so (with age if known)
+    if (g_tally.stale) {
+        timeStr = "STALE";
+        time_t epoch = time(nullptr);
+        if (g_tally.restoredEpoch != 0 && epoch > (time_t)g_tally.restoredEpoch) {
+            uint32_t ageMin = (uint32_t)(epoch - g_tally.restoredEpoch) / 60;
+            timeStr += " " + String(ageMin) + "m";
+        }
+    }
+    tallyScreen.setTextColor(PAL_WHITE, PAL_BLACK);
     int16_t timeWidth = tallyScreen.textWidth(timeStr);
     int16_t timeX = clockCenterX - (timeWidth / 2);
     if (timeX < 0) timeX = 0;
@@ -112,7 +199,7 @@ void refreshTallyScreen() {
         }
     }
 
-    uint16_t wifiColor = wifiConnected ? TFT_WHITE : TFT_DARKGREY;
+    uint8_t wifiColor = wifiConnected ? PAL_WHITE : PAL_DARKGREY;
 
     // Draw up to 4 vertical bars, left to right, increasing height
     const int barWidth   = 2;
@@ -156,7 +243,7 @@ void refreshTallyScreen() {
     int mqttX = mqttCenterX - 7;   // box is 14px wide
     int mqttY = row0Y + 2;         // positioned close to the Clock/SoC baseline
     bool mqttConnected = eff.mqtt_isConnected;
-    uint16_t mqttColor = mqttConnected ? TFT_WHITE : TFT_DARKGREY;
+    uint8_t mqttColor = mqttConnected ? PAL_WHITE : PAL_DARKGREY;
 
     tallyScreen.drawRect(mqttX, mqttY, 14, 10, mqttColor);
     if (mqttConnected) {
@@ -182,14 +269,14 @@ void refreshTallyScreen() {
     const int batBodyY  = row0Y;
 
     // Draw main battery rectangle
-    tallyScreen.drawRect(batBodyX, batBodyY, batWidth, batHeight, TFT_WHITE);
+    tallyScreen.drawRect(batBodyX, batBodyY, batWidth, batHeight, PAL_WHITE);
 
     // Draw the positive terminal as a small tab on the right
     const int termWidth  = 4;
     const int termHeight = batHeight / 2;
     const int termX      = batBodyX + batWidth;
     const int termY      = batBodyY + (batHeight - termHeight) / 2;
-    tallyScreen.drawRect(termX, termY, termWidth, termHeight, TFT_WHITE);
+    tallyScreen.drawRect(termX, termY, termWidth, termHeight, PAL_WHITE);
 
     // Fill level inside the battery
     int fillMaxWidth = batWidth - 4;   // leave a small margin inside
@@ -200,9 +287,7 @@ void refreshTallyScreen() {
     int fillY = batBodyY + 2;
     int fillH = batHeight - 4;
 
-    uint16_t darkRed    = M5.Display.color565(150, 0, 0);
-    uint16_t darkerGreen= M5.Display.color565(0, 120, 0);
-    uint16_t fillColor = (soc <= 20.0f) ? darkRed : darkerGreen;
+    uint8_t fillColor = (soc <= 20.0f) ? PAL_BAT_LOW : PAL_BAT_OK;
     tallyScreen.fillRect(fillX, fillY, fillWidth, fillH, fillColor);
 
     // SoC text horizontally centered inside the battery body (e.g., "100" or "75")
@@ -215,7 +300,7 @@ void refreshTallyScreen() {
     int16_t socY = row0Y;
 
     // Draw SoC text transparently over the fill so color shows through
-    tallyScreen.setTextColor(TFT_WHITE);
+    tallyScreen.setTextColor(PAL_WHITE);
     tallyScreen.setCursor(socX, socY);
     tallyScreen.print(socStr);
     
@@ -227,9 +312,15 @@ void refreshTallyScreen() {
     bool isProgram = false;
     bool isPreview = false;
 
+    // Dimmed colors for unconfirmed (warm-start) state or a dimmed UMD lamp
+    bool dimmed = g_tally.stale;
+
     if (selectedId != 0) {
         isProgram = g_tally.isProgram(selectedId);
         isPreview = g_tally.isPreview(selectedId);
+        if (const AtemInputInfo* info = g_tally.findInput(selectedId)) {
+            dimmed = dimmed || info->brightness < 3;
+        }
     }
 
     // --- Background color based on tally state ---
@@ -243,13 +334,15 @@ void refreshTallyScreen() {
     TallyColor currentColor;
     if (isProgram) {
         currentColor = TallyColor::Red;
-        tallyScreen.fillRect(0, statusBarHeight, tft_width, tft_heigth - statusBarHeight, TFT_RED);
+        tallyScreen.fillRect(0, statusBarHeight, tft_width, tft_heigth - statusBarHeight,
+                              dimmed ? PAL_PROGRAM_STALE : PAL_PROGRAM);
     } else if (isPreview) {
         currentColor = TallyColor::Green;
-        tallyScreen.fillRect(0, statusBarHeight, tft_width, tft_heigth - statusBarHeight, TFT_GREEN);
+        tallyScreen.fillRect(0, statusBarHeight, tft_width, tft_heigth - statusBarHeight,
+                              dimmed ? PAL_PREVIEW_STALE : PAL_PREVIEW);
     } else {
         currentColor = TallyColor::Black;
-        tallyScreen.fillRect(0, statusBarHeight, tft_width, tft_heigth - statusBarHeight, TFT_BLACK);
+        tallyScreen.fillRect(0, statusBarHeight, tft_width, tft_heigth - statusBarHeight, PAL_BLACK);
     }
 
     // If tally color changed since last frame, publish to MQTT
@@ -324,7 +417,7 @@ void refreshTallyScreen() {
         // Use a mid-size font that is easy to read but not overpowering
         tallyScreen.setFont(&fonts::DejaVu9);
         tallyScreen.setTextSize(2);
-        tallyScreen.setTextColor(TFT_WHITE, TFT_BLACK);
+        tallyScreen.setTextColor(PAL_WHITE, PAL_BLACK);
 
         // Compute basic layout for three equal-width columns, with a small horizontal margin
         int marginX   = 4;                         // inset columns from left/right edges
@@ -342,13 +435,13 @@ void refreshTallyScreen() {
         if (boxTopY < 0) boxTopY = 0;
 
         // Dynamic border color for SEL column: match the current tally state
-        uint16_t selBorderColor;
+        uint8_t selBorderColor;
         if (isProgram) {
-            selBorderColor = TFT_RED;
+            selBorderColor = PAL_PROGRAM;
         } else if (isPreview) {
-            selBorderColor = TFT_GREEN;
+            selBorderColor = PAL_PREVIEW;
         } else {
-            selBorderColor = TFT_BLACK;
+            selBorderColor = PAL_BLACK;
         }
 
         // Column 1: SEL (selected input label or literal "SEL" if none)
@@ -367,7 +460,7 @@ void refreshTallyScreen() {
         int16_t prevTextX = col2X + (colWidth - prevTextW) / 2;
         if (prevTextX < col2X + 2) prevTextX = col2X + 2;
 
-        tallyScreen.drawRect(col2X + 1, boxTopY, colWidth - 2, boxHeight, TFT_GREEN);
+        tallyScreen.drawRect(col2X + 1, boxTopY, colWidth - 2, boxHeight, PAL_PREVIEW);
         tallyScreen.setCursor(prevTextX, row1Y);
         tallyScreen.print(prevText);
 
@@ -377,7 +470,7 @@ void refreshTallyScreen() {
         int16_t progTextX = col3X + (colWidth - progTextW) / 2;
         if (progTextX < col3X + 2) progTextX = col3X + 2;
 
-        tallyScreen.drawRect(col3X + 1, boxTopY, colWidth - 2, boxHeight, TFT_RED);
+        tallyScreen.drawRect(col3X + 1, boxTopY, colWidth - 2, boxHeight, PAL_PROGRAM);
         tallyScreen.setCursor(progTextX, row1Y);
         tallyScreen.print(progText);
     }
@@ -387,7 +480,7 @@ void refreshTallyScreen() {
         // Use a large built-in DejaVu56 GFX font and fake a bold effect by overdrawing
         tallyScreen.setFont(&fonts::DejaVu72);
         tallyScreen.setTextSize(1);
-        tallyScreen.setTextColor(TFT_WHITE);
+        tallyScreen.setTextColor(PAL_WHITE);
 
         int nameFontHeight = tallyScreen.fontHeight();
 
@@ -404,7 +497,7 @@ void refreshTallyScreen() {
         tallyScreen.print(friendlyLabel);
     }
 
-    tallyScreen.pushSprite(0,0);
+    display_push(tallyScreen, 0, 0);
 }
 
 
@@ -424,9 +517,10 @@ void refreshPowerScreen() {
     powerScreen.printf("USB:\r\n  V: %.3fv  I: %.3fma\r\n", pwr.vbusVoltage, pwr.vbusCurrent);
     powerScreen.printf("5V-In:\r\n  V: %.3fv  I: %.3fma\r\n", pwr.vinVoltage, pwr.vinCurrent);
     powerScreen.printf("APS:\r\n  V: %.3fv\r\n", pwr.apsVoltage);
-    powerScreen.printf("AXP:\r\n  Temp: %.1fc", pwr.tempInAXP192);
+    powerScreen.printf("AXP:\r\n  Temp: %.1fc\r\n", pwr.tempInAXP192);
+    powerScreen.printf("LCD: blocked %uus (max %uus)", displayStats.lastBlockedUs, displayStats.maxBlockedUs);
 
-    powerScreen.pushSprite(5,10);
+    display_push(powerScreen, 5, 10);
 
 }
 
@@ -435,21 +529,7 @@ void refreshSetupScreen() {
 
     const auto eff = g_config.effective();
    
-    String strTimeStatus;
-    strTimeStatus.reserve(16);
-    switch (timeStatus()) {
-        case (timeNotSet):
-            strTimeStatus= "Not Set";
-            break;
-        case (timeNeedsSync):
-            strTimeStatus = "Needs Sync";
-            break;
-        case (timeSet):
-            strTimeStatus = "Set";
-            break;
-        default:
-            break;
-    }
+    String strTimeStatus = time_statusName();
     
     setupScreen.fillSprite(TFT_BLACK);
     setupScreen.setTextColor(TFT_WHITE);
@@ -467,7 +547,7 @@ void refreshSetupScreen() {
     setupScreen.println();
     setupScreen.println("MQTT Server: " + String(eff.mqttServer) + ":" + String(eff.mqttPort));
     setupScreen.println("Connected: " + String(eff.mqtt_isConnected ? "Yes" : "No"));
-    setupScreen.pushSprite(10,10);
+    display_push(setupScreen, 10, 10);
 
 }
 
@@ -480,7 +560,7 @@ void refreshStartupScreen() {
         startupScreen.setTextSize(startupLogEntries[i].textSize);
         startupScreen.println(startupLogEntries[i].logMessage);
     }
-    startupScreen.pushSprite(5,5);
+    display_push(startupScreen, 5, 5);
 }
 
 
@@ -516,8 +596,11 @@ void changeScreen(int newScreen) {
             // startupScreen.setRotation(3);
             break;
         case SCREEN_TALLY:
-            // tallyScreen
+            // tallyScreen (palette-indexed, see PAL_*)
+            tallyScreen.setColorDepth(TALLY_COLOR_DEPTH);
             tallyScreen.createSprite(tft_width, tft_heigth);
+            tallyScreen.createPalette();
+            initTallyPalette();
             // tallyScreen.setRotation(3);
             break;
         case SCREEN_POWER:
@@ -608,5 +691,8 @@ void startupLog(const char* in_logMessage, int in_textSize) {
     strncpy(startupLogEntries[index_startupLog].logMessage, in_logMessage, 64);
     startupLogEntries[index_startupLog].logMessage[64] = '\0';
     startupLogEntries[index_startupLog].textSize = in_textSize;
-    refreshStartupScreen();
+    // Startup may continue in the background after the tally screen is up
+    if (currentScreen == SCREEN_STARTUP) {
+        refreshStartupScreen();
+    }
 }
\ No newline at end of file
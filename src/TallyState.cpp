@@ -1,12 +1,234 @@
 #include "TallyState.h"
 
+// Updates older than this many sequence numbers behind are treated as
+// reordered and dropped; a bigger jump back means the sender restarted.
+static const uint32_t COMBINED_SEQ_WINDOW = 64;
+
+// Without a datagram (or heartbeat) for this long, MQTT takes over again
+static const uint32_t FAST_PATH_TIMEOUT_MS = 3000;
+
+static uint64_t maskFor(uint8_t input) {
+    return (input != 0 && input < 64) ? (1ULL << input) : 0;
+}
+
+static uint8_t lowestInput(uint64_t mask) {
+    for (uint8_t i = 1; i < 64; ++i) {
+        if (mask & (1ULL << i)) return i;
+    }
+    return 0;
+}
+
+static const char* const BUS_NAMES[TALLY_BUS_COUNT] = {
+    "me1", "me2", "me3", "me4", "ssrc", "aux1", "aux2", "aux3"
+};
+
+// Effective program/preview: OR of the bus sets the rules select
+static void evaluate(TallyState& t) {
+    uint64_t program = 0, preview = 0;
+    for (uint8_t b = 0; b < TALLY_BUS_COUNT; ++b) {
+        if (t.programBuses & (1u << b)) program |= t.busProgram[b];
+        if (t.previewBuses & (1u << b)) preview |= t.busPreview[b];
+    }
+    t.programMask = program;
+    t.previewMask = preview;
+}
+
+void TallyState::setProgramInput(uint8_t input) {
+    programInput = input;
+    busProgram[0] = maskFor(input);
+    evaluate(*this);
+}
+
+void TallyState::setPreviewInput(uint8_t input) {
+    previewInput = input;
+    busPreview[0] = maskFor(input);
+    evaluate(*this);
+}
+
+void TallyState::resetBuses(TallyBus keep) {
+    const uint8_t k = static_cast<uint8_t>(keep);
+    for (uint8_t b = 0; b < TALLY_BUS_COUNT; ++b) {
+        if (b == k) continue;
+        busProgram[b] = 0;
+        busPreview[b] = 0;
+    }
+    evaluate(*this);
+    programInput = lowestInput(programMask);
+    previewInput = lowestInput(previewMask);
+}
+
+void TallyState::setBusRules(uint8_t program, uint8_t preview) {
+    programBuses = program;
+    previewBuses = preview;
+    evaluate(*this);
+}
+
+uint8_t TallyState::parseBusList(const String& list) {
+    uint8_t buses = 0;
+    int start = 0;
+    while (start <= (int)list.length()) {
+        int end = list.indexOf(',', start);
+        if (end < 0) end = list.length();
+        String name = list.substring(start, end);
+        name.trim();
+        name.toLowerCase();
+        for (uint8_t b = 0; b < TALLY_BUS_COUNT; ++b) {
+            if (name == BUS_NAMES[b]) buses |= (1u << b);
+        }
+        start = end + 1;
+    }
+    return buses;
+}
+
+static void commitProgram(TallyState& t, uint8_t input) {
+    t.setProgramInput(input);
+    t.programKnown = true;
+    if (t.previewKnown) t.stale = false;
+}
+
+static void commitPreview(TallyState& t, uint8_t input) {
+    t.setPreviewInput(input);
+    t.previewKnown = true;
+    if (t.programKnown) t.stale = false;
+}
+
+void TallyState::stageProgram(uint8_t input, uint32_t nowMs, uint16_t windowMs) {
+    if (heldPreview) {
+        // Counterpart of the held change: apply both in one step
+        heldPreview = false;
+        commitPreview(*this, heldPreviewInput);
+        commitProgram(*this, input);
+        coalescedCount++;
+        return;
+    }
+    if (windowMs == 0 || (!heldProgram && programKnown && input == programInput)) {
+        commitProgram(*this, input);   // nothing to filter
+        return;
+    }
+    if (!heldProgram) {
+        heldDeadlineMs = nowMs + windowMs;
+    }
+    heldProgram      = true;
+    heldProgramInput = input;
+}
+
+void TallyState::stagePreview(uint8_t input, uint32_t nowMs, uint16_t windowMs) {
+    if (heldProgram) {
+        heldProgram = false;
+        commitPreview(*this, input);
+        commitProgram(*this, heldProgramInput);
+        coalescedCount++;
+        return;
+    }
+    if (windowMs == 0 || (!heldPreview && previewKnown && input == previewInput)) {
+        commitPreview(*this, input);
+        return;
+    }
+    if (!heldPreview) {
+        heldDeadlineMs = nowMs + windowMs;
+    }
+    heldPreview      = true;
+    heldPreviewInput = input;
+}
+
+void TallyState::serviceCoalesce(uint32_t nowMs) {
+    if (!heldProgram && !heldPreview) {
+        return;
+    }
+    if (static_cast<int32_t>(nowMs - heldDeadlineMs) < 0) {
+        return;
+    }
+    if (heldProgram) commitProgram(*this, heldProgramInput);
+    if (heldPreview) commitPreview(*this, heldPreviewInput);
+    heldProgram = false;
+    heldPreview = false;
+    coalesceTimeouts++;
+}
+
+bool TallyState::applyCombined(uint32_t seq, const uint64_t program[TALLY_BUS_COUNT],
+                               const uint64_t preview[TALLY_BUS_COUNT]) {
+    if (combinedActive) {
+        uint32_t behind = combinedSeq - seq;
+        if (behind != 0 && behind < COMBINED_SEQ_WINDOW) {
+            return false;
+        }
+    }
+
+    heldProgram    = false;   // combined state supersedes anything held
+    heldPreview    = false;
+    for (uint8_t b = 0; b < TALLY_BUS_COUNT; ++b) {
+        busProgram[b] = program[b] & ~1ULL;   // bit 0 is "no input"
+        busPreview[b] = preview[b] & ~1ULL;
+    }
+    evaluate(*this);
+    programInput   = lowestInput(programMask);
+    previewInput   = lowestInput(previewMask);
+    combinedSeq    = seq;
+    combinedActive = true;
+    programKnown   = true;
+    previewKnown   = true;
+    stale          = false;
+    return true;
+}
+
+bool TallyState::applyFast(uint32_t seq, uint8_t program, uint8_t preview, uint32_t nowMs) {
+    if (atemDirect) {
+        return false;   // the switcher itself is the better source
+    }
+    if (fastPathActive(nowMs)) {
+        uint32_t behind = fastSeq - seq;
+        if (behind < COMBINED_SEQ_WINDOW) {
+            if (behind == 0) fastLastMs = nowMs;   // heartbeat / duplicate
+            return false;
+        }
+    } else {
+        resetBuses();   // taking over: only ME1 is fed from here on
+    }
+
+    heldProgram  = false;
+    heldPreview  = false;
+    setProgramInput(program);
+    setPreviewInput(preview);
+    fastSeq      = seq;
+    fastLastMs   = nowMs;
+    fastSeen     = true;
+    programKnown = true;
+    previewKnown = true;
+    stale        = false;
+    return true;
+}
+
+void TallyState::applySets(uint64_t program, uint64_t preview, TallyBus bus) {
+    const uint8_t b = static_cast<uint8_t>(bus);
+    heldProgram   = false;
+    heldPreview   = false;
+    busProgram[b] = program & ~1ULL;
+    busPreview[b] = preview & ~1ULL;
+    evaluate(*this);
+    programInput = lowestInput(programMask);
+    previewInput = lowestInput(previewMask);
+    programKnown = true;
+    previewKnown = true;
+    stale        = false;
+}
+
+bool TallyState::fastPathActive(uint32_t nowMs) const {
+    return fastSeen && (nowMs - fastLastMs) < FAST_PATH_TIMEOUT_MS;
+}
+
+bool TallyState::directSourceActive(uint32_t nowMs) const {
+    return atemDirect || umdDirect || fastPathActive(nowMs);
+}
+
 // Helpers
 bool TallyState::isProgram(uint8_t input) const {
-    return input != 0 && input == programInput;
+    if (input == 0) return false;
+    return (input < 64) ? ((programMask >> input) & 1ULL) != 0 : input == programInput;
 }
 
 bool TallyState::isPreview(uint8_t input) const {
-    return input != 0 && input == previewInput;
+    if (input == 0) return false;
+    return (input < 64) ? ((previewMask >> input) & 1ULL) != 0 : input == previewInput;
 }
 
 const AtemInputInfo* TallyState::findInput(uint8_t input) const {
@@ -0,0 +1,506 @@
+#include <M5Unified.h>
+#include <WiFi.h>
+#include <esp_sntp.h>
+#include <time.h>
+#include <sys/time.h>
+#include <esp_timer.h>
+#include <Preferences.h>
+
+#include "ConfigState.h"
+#include "TimeModule.h"
+#include "ScreenModule.h"
+
+extern ConfigState g_config;
+
+static bool     g_timeInitialized       = false;   // SNTP started with current server/zone
+static bool     g_timeInitRequested     = false;
+static uint32_t g_timeInitRequestedAtMs = 0;
+static constexpr uint32_t TIME_INIT_DEBOUNCE_MS = 2000; // 2s debounce
+
+// Anything before 2021-01-01 means the clock was never set
+static constexpr time_t TIME_VALID_EPOCH = 1609459200;
+
+// Set from the lwIP task when SNTP adjusts the clock; consumed in loop()
+static volatile bool s_sntpSyncEvent = false;
+
+// SNTP keeps a pointer to the server name, so it must outlive the call
+static char s_ntpServer[64];
+
+// --- IANA -> POSIX TZ table -----------------------------------
+//
+// Zones we are realistically deployed in. Anything else can be given as a
+// fixed offset ("GMT-6", "UTC+5:30") or as a raw POSIX string.
+struct TzEntry {
+    const char* iana;
+    const char* posix;
+};
+
+static const TzEntry TZ_TABLE[] = {
+    { "Etc/UTC",             "UTC0" },
+    { "UTC",                 "UTC0" },
+    { "Etc/GMT",             "GMT0" },
+    { "GMT",                 "GMT0" },
+    // North America
+    { "America/New_York",    "EST5EDT,M3.2.0,M11.1.0" },
+    { "America/Detroit",     "EST5EDT,M3.2.0,M11.1.0" },
+    { "America/Toronto",     "EST5EDT,M3.2.0,M11.1.0" },
+    { "America/Indiana/Indianapolis", "EST5EDT,M3.2.0,M11.1.0" },
+    { "America/Chicago",     "CST6CDT,M3.2.0,M11.1.0" },
+    { "America/Winnipeg",    "CST6CDT,M3.2.0,M11.1.0" },
+    { "America/Mexico_City", "CST6" },
+    { "America/Regina",      "CST6" },
+    { "America/Denver",      "MST7MDT,M3.2.0,M11.1.0" },
+    { "America/Edmonton",    "MST7MDT,M3.2.0,M11.1.0" },
+    { "America/Boise",       "MST7MDT,M3.2.0,M11.1.0" },
+    { "America/Phoenix",     "MST7" },
+    { "America/Los_Angeles", "PST8PDT,M3.2.0,M11.1.0" },
+    { "America/Vancouver",   "PST8PDT,M3.2.0,M11.1.0" },
+    { "America/Anchorage",   "AKST9AKDT,M3.2.0,M11.1.0" },
+    { "America/Halifax",     "AST4ADT,M3.2.0,M11.1.0" },
+    { "America/St_Johns",    "NST3:30NDT,M3.2.0,M11.1.0" },
+    { "America/Puerto_Rico", "AST4" },
+    { "Pacific/Honolulu",    "HST10" },
+    // South America
+    { "America/Sao_Paulo",   "<-03>3" },
+    { "America/Argentina/Buenos_Aires", "<-03>3" },
+    { "America/Bogota",      "<-05>5" },
+    { "America/Lima",        "<-05>5" },
+    // Europe / Africa
+    { "Europe/London",       "GMT0BST,M3.5.0/1,M10.5.0" },
+    { "Europe/Dublin",       "IST-1GMT0,M10.5.0,M3.5.0/1" },
+    { "Europe/Lisbon",       "WET0WEST,M3.5.0/1,M10.5.0" },
+    { "Europe/Berlin",       "CET-1CEST,M3.5.0,M10.5.0/3" },
+    { "Europe/Paris",        "CET-1CEST,M3.5.0,M10.5.0/3" },
+    { "Europe/Amsterdam",    "CET-1CEST,M3.5.0,M10.5.0/3" },
+    { "Europe/Madrid",       "CET-1CEST,M3.5.0,M10.5.0/3" },
+    { "Europe/Rome",         "CET-1CEST,M3.5.0,M10.5.0/3" },
+    { "Europe/Stockholm",    "CET-1CEST,M3.5.0,M10.5.0/3" },
+    { "Europe/Warsaw",       "CET-1CEST,M3.5.0,M10.5.0/3" },
+    { "Europe/Athens",       "EET-2EEST,M3.5.0/3,M10.5.0/4" },
+    { "Europe/Helsinki",     "EET-2EEST,M3.5.0/3,M10.5.0/4" },
+    { "Europe/Kiev",         "EET-2EEST,M3.5.0/3,M10.5.0/4" },
+    { "Europe/Moscow",       "MSK-3" },
+    { "Africa/Lagos",        "WAT-1" },
+    { "Africa/Johannesburg", "SAST-2" },
+    { "Africa/Nairobi",      "EAT-3" },
+    // Asia / Oceania
+    { "Asia/Dubai",          "<+04>-4" },
+    { "Asia/Kolkata",        "IST-5:30" },
+    { "Asia/Bangkok",        "<+07>-7" },
+    { "Asia/Singapore",      "<+08>-8" },
+    { "Asia/Manila",         "PST-8" },
+    { "Asia/Shanghai",       "CST-8" },
+    { "Asia/Hong_Kong",      "HKT-8" },
+    { "Asia/Seoul",          "KST-9" },
+    { "Asia/Tokyo",          "JST-9" },
+    { "Australia/Perth",     "AWST-8" },
+    { "Australia/Brisbane",  "AEST-10" },
+    { "Australia/Sydney",    "AEST-10AEDT,M10.1.0,M4.1.0/3" },
+    { "Australia/Melbourne", "AEST-10AEDT,M10.1.0,M4.1.0/3" },
+    { "Australia/Adelaide",  "ACST-9:30ACDT,M10.1.0,M4.1.0/3" },
+    { "Pacific/Auckland",    "NZST-12NZDT,M9.5.0,M4.1.0/3" },
+};
+
+// Parse "+H", "-H", "+H:MM", "-HHMM" after a GMT/UTC prefix. Returns the
+// offset east of UTC in minutes.
+static bool parseUtcOffset(const char* s, int& minutesEast) {
+    if (*s != '+' && *s != '-') return false;
+    int sign = (*s == '-') ? -1 : 1;
+    s++;
+
+    int hours = 0, mins = 0, digits = 0;
+    while (*s >= '0' && *s <= '9' && digits < 2) {
+        hours = hours * 10 + (*s - '0');
+        s++; digits++;
+    }
+    if (digits == 0) return false;
+    if (*s == ':') s++;
+    if (*s >= '0' && *s <= '9') {
+        if (!(s[1] >= '0' && s[1] <= '9')) return false;
+        mins = (s[0] - '0') * 10 + (s[1] - '0');
+        s += 2;
+    }
+    if (*s != '\0' || hours > 14 || mins > 59) return false;
+
+    minutesEast = sign * (hours * 60 + mins);
+    return true;
+}
+
+const char* time_posixTzFor(const String& tz) {
+    static char fixedBuf[16];
+
+    for (const TzEntry& e : TZ_TABLE) {
+        if (tz.equalsIgnoreCase(e.iana)) {
+            return e.posix;
+        }
+    }
+
+    // Fixed offsets. "Etc/GMT+6" follows POSIX sign (= UTC-6); the bare
+    // "GMT-6" / "UTC-6" form is read the way people write it (= UTC-6).
+    int minutesEast = 0;
+    bool parsed = false;
+    const char* s = tz.c_str();
+    if (strncasecmp(s, "Etc/GMT", 7) == 0 && parseUtcOffset(s + 7, minutesEast)) {
+        minutesEast = -minutesEast;
+        parsed = true;
+    } else if ((strncasecmp(s, "GMT", 3) == 0 || strncasecmp(s, "UTC", 3) == 0) &&
+               parseUtcOffset(s + 3, minutesEast)) {
+        parsed = true;
+    }
+    if (parsed) {
+        // POSIX offsets are west-positive
+        int west = -minutesEast;
+        char sign = (west < 0) ? '-' : '+';
+        if (west < 0) west = -west;
+        snprintf(fixedBuf, sizeof(fixedBuf), "UTC%c%d:%02d", sign, west / 60, west % 60);
+        return fixedBuf;
+    }
+
+    // Already a POSIX rule (e.g. "CST6CDT,M3.2.0,M11.1.0")?
+    for (size_t i = 0; i < tz.length(); ++i) {
+        if (isdigit((unsigned char)tz[i])) {
+            return tz.c_str();
+        }
+    }
+
+    Serial.printf("[time] Unknown timezone '%s', using UTC\n", tz.c_str());
+    return "UTC0";
+}
+
+// --- BM8563 RTC + drift tracking ------------------------------
+//
+// The RTC (UTC, 1 s resolution) seeds the system clock at boot, so the
+// clock is right before any network is up. Every NTP sync is written back
+// and used to measure two drifts, persisted in NVS:
+//   - RTC drift: corrects the seed after a long power-off.
+//   - System clock drift: spaces out SNTP resyncs.
+static const char* RTC_NAMESPACE = "rtc_time";
+static const char* RTC_KEY       = "drift";
+static constexpr uint32_t RTC_DRIFT_MAGIC = 0x52544331; // "RTC1"
+
+struct RtcDriftRecord {
+    uint32_t magic;
+    uint32_t rtcSetEpoch;     // last time the RTC was written from NTP
+    float    rtcPpm;          // + = RTC runs fast
+    float    sysPpm;          // + = system clock runs fast
+    uint8_t  rtcPpmValid;
+    uint8_t  sysPpmValid;
+    uint8_t  reserved[2];
+};
+static RtcDriftRecord s_drift = {};
+
+// Need this much time between samples before 1 s RTC resolution gives a
+// usable ppm figure (1 s / 6 h ~ 46 ppm).
+static constexpr uint32_t RTC_DRIFT_MIN_SPAN_S = 6UL * 3600UL;
+static constexpr uint32_t SYS_DRIFT_MIN_SPAN_S = 600UL;
+
+// Resync often enough to stay within this error, within these bounds
+static constexpr float    MAX_CLOCK_ERROR_S     = 0.5f;
+static constexpr uint32_t SYNC_INTERVAL_MIN_MS  = 3600UL * 1000UL;      // 1 h
+static constexpr uint32_t SYNC_INTERVAL_MAX_MS  = 86400UL * 1000UL;     // 24 h
+
+static bool     s_timeFromRtc     = false;   // seeded from RTC this boot
+static bool     s_rtcWritePending = false;
+static uint32_t s_rtcWriteQueuedMs = 0;
+
+// Previous NTP sync, for system clock drift (monotonic vs. NTP)
+static int64_t  s_lastSyncMonoUs  = 0;
+static int64_t  s_lastSyncEpochUs = 0;
+
+// Deferred first SNTP start when the RTC seed is trusted
+static uint32_t s_sntpStartAfterMs = 0;
+static bool     s_sntpWanted       = false;
+
+static void loadDriftRecord() {
+    Preferences p;
+    p.begin(RTC_NAMESPACE, true);
+    size_t len = p.getBytes(RTC_KEY, &s_drift, sizeof(s_drift));
+    p.end();
+    if (len != sizeof(s_drift) || s_drift.magic != RTC_DRIFT_MAGIC) {
+        memset(&s_drift, 0, sizeof(s_drift));
+        s_drift.magic = RTC_DRIFT_MAGIC;
+    }
+}
+
+static void saveDriftRecord() {
+    Preferences p;
+    p.begin(RTC_NAMESPACE, false);
+    p.putBytes(RTC_KEY, &s_drift, sizeof(s_drift));
+    p.end();
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date (no timegm() in newlib)
+static int32_t daysFromCivil(int y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int32_t era = (y >= 0 ? y : y - 399) / 400;
+    const uint32_t yoe = (uint32_t)(y - era * 400);
+    const uint32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+// RTC -> UTC epoch seconds. Returns false if the RTC lost power or is unset.
+static bool readRtcEpoch(time_t& out) {
+    if (!M5.Rtc.isEnabled() || M5.Rtc.getVoltLow()) {
+        return false;
+    }
+    m5::rtc_datetime_t dt;
+    if (!M5.Rtc.getDateTime(&dt)) {
+        return false;
+    }
+    out = (time_t)daysFromCivil(dt.date.year, dt.date.month, dt.date.date) * 86400
+        + dt.time.hours * 3600 + dt.time.minutes * 60 + dt.time.seconds;
+    return out > TIME_VALID_EPOCH;
+}
+
+static uint32_t syncIntervalForDrift() {
+    if (!s_drift.sysPpmValid || s_drift.sysPpm == 0.0f) {
+        return SYNC_INTERVAL_MIN_MS;
+    }
+    float ppm = fabsf(s_drift.sysPpm);
+    float seconds = MAX_CLOCK_ERROR_S / (ppm * 1e-6f);
+    uint32_t ms = (seconds * 1000.0f > (float)SYNC_INTERVAL_MAX_MS)
+                      ? SYNC_INTERVAL_MAX_MS : (uint32_t)(seconds * 1000.0f);
+    return (ms < SYNC_INTERVAL_MIN_MS) ? SYNC_INTERVAL_MIN_MS : ms;
+}
+
+// Blend a new ppm sample into a stored estimate
+static void updatePpm(float& ppm, uint8_t& valid, float sample) {
+    ppm   = valid ? (ppm + sample) * 0.5f : sample;
+    valid = 1;
+}
+
+// Called on each NTP sync (from loop): measure drifts, queue the RTC write.
+static void onNtpSyncedFromLoop() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    int64_t epochUs = (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+    int64_t monoUs  = esp_timer_get_time();
+
+    // System clock: how far the monotonic clock disagreed with NTP since
+    // the previous sync (both run from the same crystal)
+    if (s_lastSyncMonoUs != 0) {
+        int64_t ntpSpanUs  = epochUs - s_lastSyncEpochUs;
+        int64_t monoSpanUs = monoUs - s_lastSyncMonoUs;
+        if (ntpSpanUs >= (int64_t)SYS_DRIFT_MIN_SPAN_S * 1000000LL) {
+            float sample = (float)(monoSpanUs - ntpSpanUs) * 1e6f / (float)ntpSpanUs;
+            updatePpm(s_drift.sysPpm, s_drift.sysPpmValid, sample);
+            sntp_set_sync_interval(syncIntervalForDrift());
+            Serial.printf("[time] System clock drift %.1f ppm, resync every %lu s\n",
+                          s_drift.sysPpm, (unsigned long)(syncIntervalForDrift() / 1000));
+        }
+    }
+    s_lastSyncMonoUs  = monoUs;
+    s_lastSyncEpochUs = epochUs;
+
+    // RTC: compare against NTP before overwriting it
+    time_t rtcEpoch;
+    if (readRtcEpoch(rtcEpoch) && s_drift.rtcSetEpoch != 0 &&
+        tv.tv_sec > (time_t)s_drift.rtcSetEpoch + (time_t)RTC_DRIFT_MIN_SPAN_S) {
+        float span   = (float)(tv.tv_sec - (time_t)s_drift.rtcSetEpoch);
+        float errorS = (float)(rtcEpoch - tv.tv_sec) - (float)tv.tv_usec * 1e-6f;
+        updatePpm(s_drift.rtcPpm, s_drift.rtcPpmValid, errorS * 1e6f / span);
+        Serial.printf("[time] RTC off by %.2f s, drift %.1f ppm\n", errorS, s_drift.rtcPpm);
+    }
+
+    s_rtcWritePending  = true;
+    s_rtcWriteQueuedMs = millis();
+}
+
+// Write the RTC right after a second boundary so its 1 s resolution costs
+// as little as possible (the RTC has no sub-second register).
+static void serviceRtcWrite() {
+    if (!s_rtcWritePending || !M5.Rtc.isEnabled()) {
+        return;
+    }
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    if (tv.tv_usec > 50000 && millis() - s_rtcWriteQueuedMs < 3000) {
+        return;   // wait for the next boundary (give up on alignment after 3 s)
+    }
+    s_rtcWritePending = false;
+
+    struct tm utc;
+    gmtime_r(&tv.tv_sec, &utc);
+    M5.Rtc.setDateTime(&utc);
+
+    s_drift.rtcSetEpoch = (uint32_t)tv.tv_sec;
+    saveDriftRecord();
+}
+
+void time_setup() {
+    loadDriftRecord();
+
+    // Local time display needs the zone even before any sync
+    const char* posix = time_posixTzFor(g_config.global.timeZone);
+    setenv("TZ", posix, 1);
+    tzset();
+
+    time_t rtcEpoch;
+    if (!readRtcEpoch(rtcEpoch)) {
+        Serial.println("[time] RTC not set, waiting for NTP");
+        requestTimeInit();
+        return;
+    }
+
+    // The RTC only counts whole seconds: assume we are mid-second, then
+    // take out the drift accumulated since it was last set.
+    double seeded = (double)rtcEpoch + 0.5;
+    double expectedErrorS = 1.0;
+    if (s_drift.rtcPpmValid && s_drift.rtcSetEpoch != 0 && rtcEpoch > (time_t)s_drift.rtcSetEpoch) {
+        double elapsed = (double)(rtcEpoch - (time_t)s_drift.rtcSetEpoch);
+        seeded -= elapsed * s_drift.rtcPpm * 1e-6;
+        expectedErrorS = 0.5 + elapsed * 5e-6;   // residual after correction
+    }
+
+    struct timeval tv;
+    tv.tv_sec  = (time_t)seeded;
+    tv.tv_usec = (suseconds_t)((seeded - (double)tv.tv_sec) * 1e6);
+    settimeofday(&tv, nullptr);
+    s_timeFromRtc = true;
+
+    char buff[40];
+    time_formatIso8601(buff, sizeof(buff));
+    Serial.printf("[time] Seeded from RTC: %s\n", buff);
+
+    // Trusted seed: no need to hit NTP right at boot
+    uint32_t deferMs = 0;
+    if (expectedErrorS < MAX_CLOCK_ERROR_S * 2) {
+        deferMs = syncIntervalForDrift() / 4;
+    }
+    s_sntpStartAfterMs = millis() + deferMs;
+    requestTimeInit();
+}
+
+// Runs in the lwIP task: only flag it, loop() does the rest.
+static void onSntpSync(struct timeval* tv) {
+    (void)tv;
+    s_sntpSyncEvent = true;
+}
+
+// (Re)start SNTP. Returns immediately; sync completes in the background and
+// is reported through onSntpSync().
+static void startTimeSync() {
+    const String& ntpServer = g_config.global.ntpServer;
+    Serial.println("[time] NTP Server: " + ntpServer);
+
+    strlcpy(s_ntpServer, ntpServer.c_str(), sizeof(s_ntpServer));
+
+    if (sntp_enabled()) {
+        sntp_stop();
+    }
+    sntp_setoperatingmode(SNTP_OPMODE_POLL);
+    sntp_setservername(0, s_ntpServer);
+    sntp_set_sync_mode(SNTP_SYNC_MODE_IMMED);
+    sntp_set_sync_interval(syncIntervalForDrift());
+    sntp_set_time_sync_notification_cb(onSntpSync);
+    sntp_init();
+
+    g_timeInitialized = true;
+
+    if (currentScreen == SCREEN_STARTUP) {
+        startupLog("Syncing time...", 1);
+    }
+}
+
+void requestTimeInit() {
+    g_timeInitRequested     = true;
+    g_timeInitRequestedAtMs = millis();
+}
+
+void requestTimeResync() {
+    // Restart SNTP even if it is already running
+    g_timeInitialized = false;
+    s_sntpStartAfterMs = 0;
+    g_config.device.ntp_isSynchronized = false;
+    requestTimeInit();
+}
+
+void serviceTimeInit() {
+    // Completion from the SNTP callback
+    if (s_sntpSyncEvent) {
+        s_sntpSyncEvent = false;
+        bool first = !g_config.device.ntp_isSynchronized;
+        g_config.device.ntp_isSynchronized = true;
+        onNtpSyncedFromLoop();
+
+        char buff[40];
+        if (time_formatIso8601(buff, sizeof(buff))) {
+            Serial.printf("[time] NTP sync, local time %s\n", buff);
+            if (first && currentScreen == SCREEN_STARTUP) {
+                char line[65];
+                snprintf(line, sizeof(line), "Local Time: %s", buff);
+                startupLog(line, 1);
+            }
+        }
+    }
+    serviceRtcWrite();
+
+    if (g_timeInitRequested) {
+        uint32_t now = millis();
+        if (now - g_timeInitRequestedAtMs < TIME_INIT_DEBOUNCE_MS) {
+            return; // still debouncing
+        }
+        g_timeInitRequested = false;
+
+        // Zone changes need no network
+        const String& tz = g_config.global.timeZone;
+        const char* posix = time_posixTzFor(tz);
+        setenv("TZ", posix, 1);
+        tzset();
+        Serial.printf("[time] Timezone: %s (%s)\n", tz.c_str(), posix);
+
+        // Only (re)start SNTP if it isn't running on this server already
+        if (!g_timeInitialized || g_config.global.ntpServer != s_ntpServer) {
+            g_timeInitialized = false;
+            s_sntpWanted = true;
+        }
+    }
+
+    // Don’t start until the network is actually ready (and, with a trusted
+    // RTC seed, until the deferral has passed)
+    if (!s_sntpWanted || WiFi.status() != WL_CONNECTED) {
+        return;
+    }
+    if ((int32_t)(millis() - s_sntpStartAfterMs) < 0) {
+        return;
+    }
+    s_sntpWanted = false;
+    startTimeSync();
+}
+
+bool time_isSet() {
+    return time(nullptr) > TIME_VALID_EPOCH;
+}
+
+const char* time_statusName() {
+    if (g_config.device.ntp_isSynchronized) return "Set";
+    if (s_timeFromRtc)                      return "RTC";
+    if (g_timeInitialized)                  return "Syncing";
+    return "Not Set";
+}
+
+bool time_formatClock(char* out, size_t len) {
+    time_t now = time(nullptr);
+    if (now <= TIME_VALID_EPOCH) {
+        return false;
+    }
+    struct tm lt;
+    localtime_r(&now, &lt);
+
+    int h12 = lt.tm_hour % 12;
+    if (h12 == 0) h12 = 12;
+    snprintf(out, len, "%d:%02d:%02d %s", h12, lt.tm_min, lt.tm_sec,
+             lt.tm_hour < 12 ? "AM" : "PM");
+    return true;
+}
+
+bool time_formatIso8601(char* out, size_t len) {
+    time_t now = time(nullptr);
+    if (now <= TIME_VALID_EPOCH) {
+        return false;
+    }
+    struct tm lt;
+    localtime_r(&now, &lt);
+    return strftime(out, len, "%Y-%m-%dT%H:%M:%S%z", &lt) > 0;
+}
@@ -0,0 +1,379 @@
+#include <WiFi.h>
+#include <errno.h>
+#include <lwip/sockets.h>
+
+#include "TslModule.h"
+
+// Without a UDP packet for this long (and no TCP sender), MQTT takes over
+static const uint32_t TSL_IDLE_MS        = 3000;
+static const uint8_t  TSL_MAX_PER_LOOP   = 8;
+
+static const size_t   TSL31_MSG_LEN      = 18;    // header, control, 16 chars
+static const size_t   TSL31_TEXT_LEN     = 16;
+static const size_t   TSL5_HEADER_LEN    = 6;     // PBC, VER, FLAGS, SCREEN
+static const size_t   TSL5_MAX_PACKET    = 2048;
+static const uint16_t TSL5_BROADCAST     = 0xFFFF;
+static const uint8_t  TSL5_FLAG_UNICODE  = 0x01;
+static const uint8_t  TSL5_FLAG_SCONTROL = 0x02;
+static const uint16_t TSL5_CTRL_DATA     = 0x8000;
+
+static const uint8_t  DLE = 0xFE;
+static const uint8_t  STX = 0x02;
+
+static int      s_udpFd    = -1;
+static int      s_listenFd = -1;
+static int      s_clientFd = -1;
+static uint16_t s_port     = 0;
+static uint32_t s_lastUdpMs = 0;
+static bool     s_udpSeen   = false;
+
+static uint32_t s_received = 0;
+static uint32_t s_rejected = 0;
+
+static uint8_t  s_rx[TSL5_MAX_PACKET];
+
+// TCP stream state
+enum class TcpMode : uint8_t { Unknown, Tsl5, Tsl31 };
+static TcpMode  s_tcpMode = TcpMode::Unknown;
+static uint8_t  s_frame[TSL5_MAX_PACKET];
+static size_t   s_frameLen   = 0;
+static bool     s_inFrame    = false;
+static bool     s_afterDle   = false;
+
+static uint16_t le16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+// --- Applying -------------------------------------------------
+
+// Working copy of program/preview for one packet, applied in one step so
+// a burst of hundreds of indexes costs one TallyState update
+struct TallyEdit {
+    uint64_t program;
+    uint64_t preview;
+    bool     inputsChanged;
+};
+
+static void setLabel(TallyState& tally, TallyEdit& edit, uint8_t input,
+                     const char* text, uint8_t brightness) {
+    auto it = tally.inputs.find(input);
+    if (it == tally.inputs.end()) {
+        AtemInputInfo info;
+        info.id           = input;
+        info.shortName    = text;
+        info.tallyEnabled = true;
+        info.brightness   = brightness;
+        tally.inputs[input] = info;
+        edit.inputsChanged = true;
+        return;
+    }
+    it->second.brightness = brightness;
+    if (text[0] != '\0' && it->second.shortName != text) {
+        it->second.shortName = text;
+    }
+}
+
+// lamps: bit 0 program, bit 1 preview
+static void applyIndex(const ConfigState& cfg, TallyState& tally, TallyEdit& edit,
+                       int index, uint8_t lamps, uint8_t brightness, const char* text) {
+    int input = index + cfg.global.tslIndexOffset;
+    if (input < 1 || input > 63) {
+        return;
+    }
+    const uint64_t bit = 1ULL << input;
+    edit.program = (lamps & 0x01) ? (edit.program | bit) : (edit.program & ~bit);
+    edit.preview = (lamps & 0x02) ? (edit.preview | bit) : (edit.preview & ~bit);
+    setLabel(tally, edit, static_cast<uint8_t>(input), text, brightness);
+}
+
+// Copy a space/NUL padded label, trimmed
+static void copyLabel(char* out, size_t outLen, const uint8_t* text, size_t len) {
+    if (len > outLen - 1) len = outLen - 1;
+    size_t n = 0;
+    for (size_t i = 0; i < len && text[i] != '\0'; ++i) {
+        out[n++] = (text[i] >= 0x20 && text[i] < 0x7F) ? static_cast<char>(text[i]) : '?';
+    }
+    while (n > 0 && out[n - 1] == ' ') n--;
+    out[n] = '\0';
+}
+
+// --- Protocol v3.1 --------------------------------------------
+
+// 0x80 + address, control (bits 0-3 tally 1-4, bits 4-5 brightness),
+// 16 chars. Tally 1 = program, tally 2 = preview.
+static bool parseTsl31(const ConfigState& cfg, TallyState& tally, TallyEdit& edit,
+                       const uint8_t* msg) {
+    if (!(msg[0] & 0x80) || (msg[1] & 0x80)) {
+        return false;
+    }
+    char label[TSL31_TEXT_LEN + 1];
+    copyLabel(label, sizeof(label), msg + 2, TSL31_TEXT_LEN);
+    applyIndex(cfg, tally, edit, msg[0] & 0x7F, msg[1] & 0x03, (msg[1] >> 4) & 0x03, label);
+    return true;
+}
+
+// --- Protocol v5.0 --------------------------------------------
+
+// PBC u16, VER u8, FLAGS u8, SCREEN u16, then DMSGs of INDEX u16,
+// CONTROL u16 (RH tally 0-1, text tally 2-3, LH tally 4-5, brightness
+// 6-7, bit 15 control data), LENGTH u16, TEXT. Little-endian throughout.
+// Lamp values: 0 off, 1 red, 2 green, 3 amber.
+static bool parseTsl5(const ConfigState& cfg, TallyState& tally, TallyEdit& edit,
+                      const uint8_t* p, size_t len) {
+    if (len < TSL5_HEADER_LEN || static_cast<size_t>(le16(p)) + 2 != len) {
+        return false;
+    }
+    const uint8_t flags = p[3];
+    if (flags & TSL5_FLAG_SCONTROL) {
+        return true;   // screen control data, nothing for us
+    }
+
+    size_t off = TSL5_HEADER_LEN;
+    while (off + 6 <= len) {
+        const uint16_t index   = le16(p + off);
+        const uint16_t control = le16(p + off + 2);
+        const uint16_t tlen    = le16(p + off + 4);
+        off += 6;
+        if (off + tlen > len) {
+            return false;
+        }
+        const uint8_t* text = p + off;
+        off += tlen;
+
+        const uint8_t brightness = (control >> 6) & 0x03;
+        if (index == TSL5_BROADCAST) {
+            // Broadcast only carries brightness for us
+            for (auto& kv : tally.inputs) kv.second.brightness = brightness;
+            continue;
+        }
+        if (control & TSL5_CTRL_DATA) {
+            continue;
+        }
+
+        char label[TSL31_TEXT_LEN + 1];
+        if (flags & TSL5_FLAG_UNICODE) {
+            // UTF-16LE: keep ASCII, replace the rest
+            uint8_t ascii[TSL31_TEXT_LEN];
+            size_t  n = 0;
+            for (size_t i = 0; i + 1 < tlen && n < sizeof(ascii); i += 2) {
+                ascii[n++] = text[i + 1] ? '?' : text[i];
+            }
+            copyLabel(label, sizeof(label), ascii, n);
+        } else {
+            copyLabel(label, sizeof(label), text, tlen);
+        }
+
+        const uint8_t lamps = (control & 0x03) | ((control >> 2) & 0x03) | ((control >> 4) & 0x03);
+        applyIndex(cfg, tally, edit, index, lamps, brightness, label);
+    }
+    return off == len;
+}
+
+// --- Dispatch -------------------------------------------------
+
+static void beginEdit(const TallyState& tally, TallyEdit& edit) {
+    edit.program       = tally.busProgram[0];   // TSL feeds ME1
+    edit.preview       = tally.busPreview[0];
+    edit.inputsChanged = false;
+}
+
+static void commitEdit(TallyState& tally, const TallyEdit& edit) {
+    if (!tally.umdDirect && !tally.atemDirect) {
+        tally.resetBuses();   // taking over: TSL only feeds ME1
+    }
+    if (edit.program != tally.busProgram[0] || edit.preview != tally.busPreview[0] ||
+        !tally.programKnown || !tally.previewKnown) {
+        tally.applySets(edit.program, edit.preview);
+    }
+    if (edit.inputsChanged) {
+        tally.normalizeSelected();
+    }
+}
+
+static void handleDatagram(const ConfigState& cfg, TallyState& tally,
+                           const uint8_t* p, size_t len) {
+    TallyEdit edit;
+    beginEdit(tally, edit);
+
+    bool ok;
+    // v5.0: PBC matches and VER is 0; a v3.1 header byte is >= 0x80 and
+    // its third byte is label text
+    if (len >= TSL5_HEADER_LEN && static_cast<size_t>(le16(p)) + 2 == len && p[2] == 0) {
+        ok = parseTsl5(cfg, tally, edit, p, len);
+    } else if (len >= TSL31_MSG_LEN && len % TSL31_MSG_LEN == 0) {
+        ok = true;
+        for (size_t off = 0; off < len && ok; off += TSL31_MSG_LEN) {
+            ok = parseTsl31(cfg, tally, edit, p + off);
+        }
+    } else {
+        ok = false;
+    }
+
+    if (!ok) {
+        s_rejected++;
+        return;
+    }
+    commitEdit(tally, edit);
+    s_received++;
+}
+
+// TCP: v5.0 packets are framed DLE/STX with DLE stuffed (DLE DLE); the
+// length comes from PBC. v3.1 senders just stream 18-byte messages.
+static void feedTcp(const ConfigState& cfg, TallyState& tally, const uint8_t* p, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t b = p[i];
+
+        if (s_tcpMode == TcpMode::Unknown) {
+            s_tcpMode = (b == DLE) ? TcpMode::Tsl5 : TcpMode::Tsl31;
+        }
+
+        if (s_tcpMode == TcpMode::Tsl31) {
+            if (s_frameLen == 0 && !(b & 0x80)) continue;   // resync on a header byte
+            s_frame[s_frameLen++] = b;
+            if (s_frameLen == TSL31_MSG_LEN) {
+                handleDatagram(cfg, tally, s_frame, s_frameLen);
+                s_frameLen = 0;
+            }
+            continue;
+        }
+
+        if (s_afterDle) {
+            s_afterDle = false;
+            if (b == STX) {
+                if (s_inFrame && s_frameLen > 0) s_rejected++;   // truncated
+                s_inFrame  = true;
+                s_frameLen = 0;
+                continue;
+            }
+            if (b != DLE) {
+                s_inFrame = false;   // not a valid escape: hunt for DLE/STX
+                continue;
+            }
+            // DLE DLE: literal 0xFE, fall through
+        } else if (b == DLE) {
+            s_afterDle = true;
+            continue;
+        }
+
+        if (!s_inFrame) continue;
+        if (s_frameLen == sizeof(s_frame)) {
+            s_inFrame = false;
+            s_rejected++;
+            continue;
+        }
+        s_frame[s_frameLen++] = b;
+        if (s_frameLen >= 2 && s_frameLen == static_cast<size_t>(le16(s_frame)) + 2) {
+            handleDatagram(cfg, tally, s_frame, s_frameLen);
+            s_inFrame  = false;
+            s_frameLen = 0;
+        }
+    }
+}
+
+// --- Sockets --------------------------------------------------
+
+static void closeFd(int& fd) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+static void resetTcpStream() {
+    s_tcpMode  = TcpMode::Unknown;
+    s_frameLen = 0;
+    s_inFrame  = false;
+    s_afterDle = false;
+}
+
+static void closeAll() {
+    if (s_udpFd >= 0 || s_listenFd >= 0) {
+        Serial.println("[TSL] listener stopped");
+    }
+    closeFd(s_clientFd);
+    closeFd(s_listenFd);
+    closeFd(s_udpFd);
+    s_port = 0;
+}
+
+static bool openAll(uint16_t port) {
+    sockaddr_in addr = {};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    s_udpFd    = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    s_listenFd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s_listenFd >= 0) {
+        int one = 1;   // rebind right after a port change
+        setsockopt(s_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    }
+    if (s_udpFd < 0 || s_listenFd < 0 ||
+        bind(s_udpFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        bind(s_listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(s_listenFd, 1) < 0) {
+        closeAll();
+        return false;
+    }
+    fcntl(s_udpFd, F_SETFL, O_NONBLOCK);
+    fcntl(s_listenFd, F_SETFL, O_NONBLOCK);
+    s_port = port;
+    Serial.printf("[TSL] listening on UDP/TCP %u\n", (unsigned)port);
+    return true;
+}
+
+void tsl_onLoop(const ConfigState& cfg, TallyState& tally) {
+    const uint16_t port = cfg.global.tslPort;
+    if (port == 0 || WiFi.status() != WL_CONNECTED) {
+        closeAll();
+        tally.umdDirect = false;
+        return;
+    }
+    if (port != s_port) {
+        closeAll();
+        if (!openAll(port)) {
+            tally.umdDirect = false;
+            return;
+        }
+    }
+
+    uint32_t now = millis();
+
+    for (uint8_t i = 0; i < TSL_MAX_PER_LOOP; ++i) {
+        int n = recv(s_udpFd, s_rx, sizeof(s_rx), MSG_DONTWAIT);
+        if (n <= 0) break;
+        s_lastUdpMs = now;
+        s_udpSeen   = true;
+        handleDatagram(cfg, tally, s_rx, static_cast<size_t>(n));
+    }
+
+    // One TCP sender at a time; a new connection replaces the old one
+    int fd = accept(s_listenFd, nullptr, nullptr);
+    if (fd >= 0) {
+        closeFd(s_clientFd);
+        s_clientFd = fd;
+        fcntl(s_clientFd, F_SETFL, O_NONBLOCK);
+        resetTcpStream();
+        Serial.println("[TSL] TCP sender connected");
+    }
+    if (s_clientFd >= 0) {
+        for (uint8_t i = 0; i < TSL_MAX_PER_LOOP; ++i) {
+            int n = recv(s_clientFd, s_rx, sizeof(s_rx), MSG_DONTWAIT);
+            if (n > 0) {
+                feedTcp(cfg, tally, s_rx, static_cast<size_t>(n));
+                continue;
+            }
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                closeFd(s_clientFd);
+                Serial.println("[TSL] TCP sender disconnected");
+            }
+            break;
+        }
+    }
+
+    tally.umdDirect = (s_clientFd >= 0) ||
+                      (s_udpSeen && now - s_lastUdpMs < TSL_IDLE_MS);
+}
+
+uint32_t tsl_received() { return s_received; }
+uint32_t tsl_rejected() { return s_rejected; }
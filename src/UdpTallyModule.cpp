@@ -0,0 +1,134 @@
+#include <WiFi.h>
+#include <errno.h>
+#include <lwip/sockets.h>
+
+#include "UdpTallyModule.h"
+
+// Non-blocking lwIP socket with a static receive buffer: WiFiUDP
+// allocates a buffer for every packet
+static int       s_fd     = -1;
+static uint32_t  s_group  = 0;     // network byte order
+static uint16_t  s_port   = 0;
+
+static uint32_t  s_received = 0;
+static uint32_t  s_rejected = 0;
+
+// At most this many datagrams per loop() pass; the rest wait for the next
+static const uint8_t UDP_TALLY_MAX_PER_LOOP = 8;
+
+static uint8_t   s_rx[UDP_TALLY_PACKET_LEN + 1];   // +1 catches oversized packets
+
+static void leaveGroup() {
+    if (s_fd >= 0) {
+        close(s_fd);   // drops the group membership too
+        s_fd = -1;
+        Serial.println("[UDP] tally multicast stopped");
+    }
+}
+
+static bool joinGroup(uint32_t group, uint16_t port) {
+    s_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s_fd < 0) {
+        return false;
+    }
+    int one = 1;   // rebind right after a port change
+    setsockopt(s_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr = {};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    ip_mreq mreq = {};
+    mreq.imr_multiaddr.s_addr = group;
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+
+    if (bind(s_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        setsockopt(s_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+        close(s_fd);
+        s_fd = -1;
+        return false;
+    }
+    fcntl(s_fd, F_SETFL, O_NONBLOCK);
+    return true;
+}
+
+// Join when enabled and Wi-Fi is up; rejoin if the group or port changed.
+static bool ensureJoined(const ConfigState& cfg) {
+    const String& groupStr = cfg.global.udpTallyGroup;
+    if (groupStr.length() == 0 || cfg.global.udpTallyPort == 0 ||
+        WiFi.status() != WL_CONNECTED) {
+        leaveGroup();
+        return false;
+    }
+
+    IPAddress ip;
+    if (!ip.fromString(groupStr)) {
+        leaveGroup();
+        return false;
+    }
+    const uint32_t group = static_cast<uint32_t>(ip);   // first octet in the low byte
+    const uint8_t  first = group & 0xFF;
+    if (first < 224 || first > 239) {
+        leaveGroup();
+        return false;
+    }
+
+    if (s_fd >= 0 && group == s_group && cfg.global.udpTallyPort == s_port) {
+        return true;
+    }
+
+    leaveGroup();
+    if (!joinGroup(group, cfg.global.udpTallyPort)) {
+        return false;   // retried next pass
+    }
+    s_group = group;
+    s_port  = cfg.global.udpTallyPort;
+    Serial.printf("[UDP] tally multicast joined %s:%u\n",
+                  groupStr.c_str(), (unsigned)s_port);
+    return true;
+}
+
+static bool parseDatagram(const uint8_t* buf, int len,
+                          uint32_t& seq, uint8_t& program, uint8_t& preview) {
+    if (len != (int)UDP_TALLY_PACKET_LEN) return false;
+    if (buf[0] != 'T' || buf[1] != 'L') return false;
+    if (buf[2] != UDP_TALLY_VERSION) return false;
+
+    seq = ((uint32_t)buf[4] << 24) | ((uint32_t)buf[5] << 16) |
+          ((uint32_t)buf[6] << 8)  |  (uint32_t)buf[7];
+    program = buf[8];
+    preview = buf[9];
+    return true;
+}
+
+void udpTally_onLoop(const ConfigState& cfg, TallyState& tally) {
+    if (!ensureJoined(cfg)) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < UDP_TALLY_MAX_PER_LOOP; ++i) {
+        int len = recv(s_fd, s_rx, sizeof(s_rx), MSG_DONTWAIT);
+        if (len <= 0) {
+            return;
+        }
+        if (tally.atemDirect) {
+            continue;   // the switcher link owns the tally; not counted
+        }
+
+        uint32_t seq;
+        uint8_t  program, preview;
+        if (!parseDatagram(s_rx, len, seq, program, preview)) {
+            s_rejected++;
+            continue;
+        }
+        if (tally.applyFast(seq, program, preview, millis())) {
+            s_received++;
+        } else if (tally.fastSeq != seq) {
+            s_rejected++;   // reordered; plain repeats are heartbeats
+        }
+    }
+}
+
+uint32_t udpTally_received() { return s_received; }
+uint32_t udpTally_rejected() { return s_rejected; }
@@ -5,17 +5,22 @@
 
 #include "ScreenModule.h"
 #include "NetworkModule.h"
+#include "TimeModule.h"
 #include "PrefsModule.h"
 #include "PowerModule.h"
 
 #include "ButtonManager.h"
 #include "ButtonRouter.h"
 #include "DisplayModule.h"
+#include "ImuModule.h"
 
 #include "ConfigState.h"
 #include "TallyState.h"
 #include "MqttClient.h"
 #include "MqttRouter.h"
+#include "UdpTallyModule.h"
+#include "AtemModule.h"
+#include "TslModule.h"
 
 #define TPS false
 #if TPS
@@ -31,6 +36,34 @@
 
 millisDelay ms_startup;
 
+// --- Asynchronous startup -------------------------------------
+//
+// setup() only does local init; the network comes up from loop() through
+// these phases. The tally screen goes live as soon as the retained
+// program/preview have arrived (or at the timeout), while NTP and other
+// non-critical work finishes in the background.
+enum class StartupPhase : uint8_t {
+    WifiConnecting,
+    MqttConnecting,
+    WaitingForTally,
+    Live
+};
+
+// Per-phase timestamps (millis() since reset; 0 = not reached yet)
+struct StartupTimeline {
+    uint32_t setupStartMs = 0;
+    uint32_t wifiUpMs     = 0;
+    uint32_t mqttUpMs     = 0;
+    uint32_t firstTallyMs = 0;
+    uint32_t timeSyncMs   = 0;
+};
+
+static const uint32_t STARTUP_TIMEOUT_MS = 30000;
+
+static StartupPhase    g_startupPhase = StartupPhase::WifiConnecting;
+static StartupTimeline g_startupTimeline;
+static bool            g_startupReported = false;
+
 // Global state
 ConfigState g_config;
 TallyState  g_tally;
@@ -41,7 +74,10 @@ ButtonRouter  g_buttonRouter(g_config, g_tally);
 
 uint32_t g_bootMillis;
 
-MqttCommand g_pendingCommand;  // global or static
+// Longest gap between two loop() entries since the last status (µs)
+static uint32_t g_loopMaxUs = 0;
+
+CommandQueue g_commands;   // MQTT router -> loop()
 
 // Track current display rotation for IMU-based orientation (landscape only)
 static int g_displayRotation = 1;
@@ -72,7 +108,30 @@ StatusSnapshot buildStatusSnapshot() {
     st.batPercentageHybrid   = static_cast<uint8_t>(pwr.batPercentageHybrid + 0.5f);
     st.coulombCount   = pwr.coulombCount;
     st.rssi       = static_cast<int8_t>(WiFi.RSSI());
+    st.wifiConnectPath = WiFi_connectPathName();
+    st.wifiConnectMs   = WiFi_connectDurationMs();
+    if (g_startupTimeline.firstTallyMs != 0) {
+        st.bootToTallyMs = g_startupTimeline.firstTallyMs - g_startupTimeline.setupStartMs;
+    }
     st.temperatureC = pwr.tempInAXP192;
+    st.displayBlockedMaxUs = displayStats.maxBlockedUs;
+    displayStats.maxBlockedUs = 0;   // report worst frame per status interval
+    st.loopMaxMs = g_loopMaxUs / 1000;
+    g_loopMaxUs = 0;
+    st.mqttBlockedMaxUs = g_mqtt.takeMaxBlockedUs();
+    st.mqttRxDropped    = g_mqtt.rxDropped();
+    st.mqttRecoverMs       = g_mqtt.lastRecoverMs();
+    st.mqttRecoverAttempts = g_mqtt.lastRecoverAttempts();
+    st.mqttReplayed        = g_mqtt.txReplayed();
+    st.mqttDropped         = g_mqtt.txDropped();
+    st.tallyCoalesced      = g_tally.coalescedCount;
+    st.tallyCoalesceTimeouts = g_tally.coalesceTimeouts;
+    st.udpTallyRx          = udpTally_received();
+    st.udpTallyRejected    = udpTally_rejected();
+    st.atemLink            = atem_linkName();
+    st.atemResends         = atem_resends();
+    st.tslRx               = tsl_received();
+    st.tslRejected         = tsl_rejected();
     st.firmwareVersion = F("2.0.0-mqtt");
     st.buildDateTime   = eff.buildDateTime;
     st.hwRevision      = F("M5StickC-Plus");
@@ -108,7 +167,7 @@ void markUserActivity()
 
 void onMqttMessage(const String& topic, const String& payload) {
     // Route into ConfigState + TallyState, and capture any command
-    handleMqttMessage(g_config, g_tally, topic, payload, g_pendingCommand);
+    handleMqttMessage(g_config, g_tally, topic, payload, g_commands);
 
     // Optional debug
     Serial.printf("[MQTT] %s => %s\n", topic.c_str(), payload.c_str());
@@ -118,56 +177,8 @@ void onMqttMessage(const String& topic, const String& payload) {
 // --------------------------------------------------------------
 // Accelerometer-driven screen orientation (landscape only)
 // --------------------------------------------------------------
-void updateScreenOrientationFromImu()
+static void applyOrientationFromAccel(float ax, float ay, float az)
 {
-    // Check at most every 250 ms to avoid jitter and wasted work (saves IMU + CPU power)
-    static uint32_t lastCheckMs = 0;
-    const uint32_t intervalMs   = 250;
-    uint32_t now = millis();
-    if (now - lastCheckMs < intervalMs) {
-        return;
-    }
-    lastCheckMs = now;
-
-    float ax, ay, az;
-    // M5Unified fills ax/ay/az with acceleration in g's
-    M5.Imu.getAccel(&ax, &ay, &az);
-
-    // Detect movement (not just flips) to drive idle-activity.
-    // We compare current accel to the previous sample and treat larger deltas
-    // as "movement", ignoring small noise.
-    {
-        static bool  haveLastAccel = false;
-        static float lastAx = 0.0f;
-        static float lastAy = 0.0f;
-        static float lastAz = 0.0f;
-
-        // Tunable motion sensitivity (in g). Typical noise is ~0.02–0.05g, so 0.15g is a
-        // reasonable "user moved the device" threshold.
-        const float motionThreshold = 0.15f;
-
-        if (haveLastAccel) {
-            float dax = ax - lastAx;
-            float day = ay - lastAy;
-            float daz = az - lastAz;
-
-            float sumAbs =
-                (dax >= 0.0f ? dax : -dax) +
-                (day >= 0.0f ? day : -day) +
-                (daz >= 0.0f ? daz : -daz);
-
-            if (sumAbs > motionThreshold) {
-                // Any significant movement counts as activity
-                markUserActivity();
-            }
-        }
-
-        lastAx = ax;
-        lastAy = ay;
-        lastAz = az;
-        haveLastAccel = true;
-    }
-
     // Decide which axis to use for landscape orientation based on which has greater magnitude.
     // On some board orientations X may dominate, on others Y will; this makes us robust.
     float absAx = (ax >= 0.0f) ? ax : -ax;
@@ -218,10 +229,103 @@ void updateScreenOrientationFromImu()
     }
 }
 
+// Driven by the IMU wake-on-motion interrupt: while the stick sits still on
+// a tripod this does no I2C reads at all.
+void updateScreenOrientationFromImu()
+{
+    float ax, ay, az;
+    if (!imu_takeMotionSample(ax, ay, az)) {
+        return;
+    }
+
+    // The IMU only interrupts above its motion threshold, so any event
+    // counts as activity (restores brightness after idle dimming).
+    markUserActivity();
+
+    applyOrientationFromAccel(ax, ay, az);
+}
+
+
+// Advance the asynchronous startup state machine (called every loop).
+static void serviceStartup()
+{
+    StartupTimeline& tl = g_startupTimeline;
+
+    // NTP finishes in the background; just note when it landed
+    if (tl.timeSyncMs == 0 && g_config.device.ntp_isSynchronized) {
+        tl.timeSyncMs = millis();
+    }
+
+    switch (g_startupPhase) {
+        case StartupPhase::WifiConnecting:
+            if (WiFi.status() == WL_CONNECTED) {
+                tl.wifiUpMs = millis();
+                startupLog("Initializing MQTT...", 1);
+                g_mqtt.begin();
+                g_startupPhase = StartupPhase::MqttConnecting;
+            }
+            break;
+
+        case StartupPhase::MqttConnecting:
+            if (g_mqtt.isConnected()) {
+                tl.mqttUpMs = millis();
+                startupLog("Waiting for tally...", 1);
+                g_startupPhase = StartupPhase::WaitingForTally;
+            }
+            break;
+
+        case StartupPhase::WaitingForTally:
+            if (g_tally.programKnown && g_tally.previewKnown) {
+                tl.firstTallyMs = millis();
+                ms_startup.stop();
+                startupLog("Startup complete.", 1);
+                g_startupPhase = StartupPhase::Live;
+                if (currentScreen == SCREEN_STARTUP) {
+                    changeScreen(SCREEN_TALLY);
+                }
+            }
+            break;
+
+        case StartupPhase::Live:
+        default:
+            break;
+    }
+
+    // Timeout: show the tally screen anyway; MQTT keeps retrying in loop()
+    if (g_startupPhase != StartupPhase::Live && ms_startup.justFinished()) {
+        ms_startup.stop();
+        startupLog("Startup incomplete.", 1);
+        g_startupPhase = StartupPhase::Live;
+        if (currentScreen == SCREEN_STARTUP) {
+            changeScreen(SCREEN_TALLY);
+        }
+    }
+
+    // Report the boot timeline once, when it is complete and can reach MQTT
+    if (!g_startupReported && tl.firstTallyMs != 0 && g_mqtt.isConnected()) {
+        g_startupReported = true;
+        // NTP may still be running (or deferred after an RTC seed)
+        char timeSync[16] = "pending";
+        if (tl.timeSyncMs != 0) {
+            snprintf(timeSync, sizeof(timeSync), "%lums",
+                     (unsigned long)(tl.timeSyncMs - tl.setupStartMs));
+        }
+        logf(LogLevel::Info,
+             "[boot] wifi=%lums mqtt=%lums first_tally=%lums time_sync=%s (path=%s)\n",
+             (unsigned long)(tl.wifiUpMs - tl.setupStartMs),
+             (unsigned long)(tl.mqttUpMs - tl.setupStartMs),
+             (unsigned long)(tl.firstTallyMs - tl.setupStartMs),
+             timeSync,
+             WiFi_connectPathName());
+    }
+}
+
 
 void setup () {
 
     Serial.begin(115200);
+    g_bootMillis = millis();
+    g_startupTimeline.setupStartMs = g_bootMillis;
 
     // Initialize M5Unified for M5StickC-Plus
     auto cfg = M5.config();
@@ -231,7 +335,15 @@ void setup () {
     // Use M5Unified display API (start in normal landscape)
     g_displayRotation = 1;
     M5.Display.setRotation(g_displayRotation);
-    updateScreenOrientationFromImu() ;  // initial orientation
+
+    // IMU wake-on-motion; take one direct reading for the initial orientation
+    imu_setup();
+    {
+        float ax, ay, az;
+        if (imu_readAccelNow(ax, ay, az)) {
+            applyOrientationFromAccel(ax, ay, az);
+        }
+    }
 
     setCpuFrequencyMhz(80); //Save battery by turning down the CPU clock
     btStop();               //Save battery by turning off Bluetooth
@@ -264,61 +376,38 @@ void setup () {
     startupLog("Initializing preferences...", 1);
     preferences_setup();
     prefs_applyToConfig(g_config);
+    prefs_loadConfig(g_config);   // last config received over MQTT
+    g_tally.setBusRules(TallyState::parseBusList(g_config.global.tallyProgramBuses),
+                        TallyState::parseBusList(g_config.global.tallyPreviewBuses));
+
+    // Wall clock from the RTC; SNTP follows in the background once WiFi is up
+    time_setup();
+
+    // Warm start: show last-known labels/tally (marked stale) right away
+    bool warmStart = prefs_restoreTallySnapshot(g_tally, g_config);
     
     // Power Management
     startupLog("Initializing power management...", 1);
     power_setup();
     power_onLoop();  // initial read
 
-    ms_startup.start(30000);
-    bool wifi_isInited = false;
-    bool mqtt_isInited = false;
-    while (ms_startup.isRunning()) {
-        
-        if (!wifi_isInited) {
-            wifi_isInited = true;
-            startupLog("Initializing WiFi...", 1);
-            WiFi_setup();
-        }
-
-        WiFi_onLoop();
-
-        if (!mqtt_isInited && WiFi.status() == WL_CONNECTED) {
-            mqtt_isInited = true;
-            startupLog("Initializing MQTT...", 1);
-            g_bootMillis = millis();
-            g_mqtt.setMessageHandler(onMqttMessage);
-            g_mqtt.begin();
-        }
-
-        g_mqtt.loop();
-
-        if (!g_config.device.ntp_isSynchronized) {
-            // Will loop until NTP sync or timeout
-            serviceTimeInit();
-        }
-
-        if (wifi_isInited && mqtt_isInited && g_config.device.ntp_isSynchronized) {
-            ms_startup.stop();
-            startupLog("Startup complete.", 1);
-        }
-
-        // Timeout hit?
-        if (ms_startup.justFinished()) {
-            ms_startup.stop();
-            startupLog("Startup incomplete.", 1);
-        }
-
-    }
-      
-    startupLog("", 1);
-    changeScreen(SCREEN_TALLY);
-
+    // Arm the watchdog before any network work so a hung startup resets us.
     // Init task watchdog: 60s timeout, panic = true (print backtrace & reset)
     esp_task_wdt_init(60, true);
     // Watch the current (Arduino) task
     esp_task_wdt_add(NULL);
 
+    // Network bring-up continues asynchronously in loop() (serviceStartup)
+    g_mqtt.setMessageHandler(onMqttMessage);
+    startupLog("Initializing WiFi...", 1);
+    WiFi_setup();
+    g_startupPhase = StartupPhase::WifiConnecting;
+    ms_startup.start(STARTUP_TIMEOUT_MS);
+
+    if (warmStart) {
+        changeScreen(SCREEN_TALLY);
+    }
+
     #if TPS
         ms_tps.start(1000);
         ms_runningAvg.start(60000);
@@ -335,12 +424,26 @@ void loop () {
     // Feed the watchdog
     esp_task_wdt_reset();
 
+    // Loop stall metric: worst time between two passes
+    static uint32_t lastLoopUs = micros();
+    uint32_t loopUs = micros();
+    if (loopUs - lastLoopUs > g_loopMaxUs) {
+        g_loopMaxUs = loopUs - lastLoopUs;
+    }
+    lastLoopUs = loopUs;
+
     M5.update();
     power_onLoop();
     WiFi_onLoop();
+    serviceStartup();
     g_mqtt.loop();
-    serviceTimeInit();      // first time NTP
-    events();               // ezTime
+    atem_onLoop(g_config, g_tally);         // direct switcher link
+    tsl_onLoop(g_config, g_tally);          // TSL UMD listener
+    udpTally_onLoop(g_config, g_tally);     // multicast fast path
+    g_tally.serviceCoalesce(millis());      // held program/preview change
+    serviceMqttConfig(g_config, g_tally);   // coalesced config burst
+    serviceTimeInit();      // SNTP (async)
+    prefs_serviceTallySnapshot(g_tally, g_config);
 
     // Periodic status publish
     static uint32_t lastStatusMs = 0;
@@ -351,12 +454,11 @@ void loop () {
         g_mqtt.publishStatus(buildStatusSnapshot());
     }
 
-    // Handle pending command (deep sleep/reboot/etc.)
-    if (g_pendingCommand.type != MqttCommandType::None) {
-        MqttCommandType cmd = g_pendingCommand.type;
-        g_pendingCommand.type = MqttCommandType::None;  // consume it
-
-        switch (cmd) {
+    // Handle queued commands (deep sleep/reboot/etc.), in arrival order
+    MqttCommand pending;
+    while (g_commands.pop(pending)) {
+        CommandAckStatus ackStatus = CommandAckStatus::Ignored;
+        switch (pending.type) {
             case MqttCommandType::DeepSleep:
                 // TODO: publish offline, flush, then enter deep sleep
                 // e.g. g_mqtt.publishAvailability("offline"); delay(50); esp_deep_sleep_start();
@@ -388,18 +490,21 @@ void loop () {
             case MqttCommandType::ResyncTime:
                 Serial.println("MQTT: ResyncTime command received");
                 requestTimeResync();
+                ackStatus = CommandAckStatus::Done;
                 break;
 
             case MqttCommandType::selectNextInput:
                 Serial.println("MQTT: selectNextInput command received");
                 g_tally.selectNextInput();
                 g_mqtt.publishSelectedInput(g_tally.selectedInput);
+                ackStatus = CommandAckStatus::Done;
                 break;
 
             case MqttCommandType::None:
             default:
                 break;
         }
+        g_mqtt.publishCommandAck(pending, ackStatus);
     }
 
     ButtonEvent ev = g_buttons.poll();
@@ -409,7 +514,7 @@ void loop () {
         markUserActivity(eff);
     }
 
-    // Update orientation (landscape only) from the accelerometer
+    // Update orientation (landscape only) when the IMU reports motion
     updateScreenOrientationFromImu();
 
     // Draw whichever screen is active (startup, tally, power, setup)
@@ -468,7 +573,10 @@ void loop () {
 
         if (ms_runningAvg.justFinished()) {
             ms_runningAvg.repeat();
-            Serial.println(localTime.dateTime(ISO8601));
+            char isoBuf[32];
+            if (time_formatIso8601(isoBuf, sizeof(isoBuf))) {
+                Serial.println(isoBuf);
+            }
             Serial.println("tps: " + String(ra_TPS.getFastAverage()) );
             Serial.println();
         }
@@ -0,0 +1,30 @@
+// Runs AtemModule against docs/atem_sim.py on 127.0.0.1 for ~7 s and
+// prints every tally change, then the input table and resend count.
+
+#include "AtemModule.h"
+#include <thread>
+
+int main() {
+    ConfigState cfg;
+    cfg.global.atemAddress = "127.0.0.1";
+    TallyState tally;
+
+    uint64_t lastProgram = ~0ULL, lastPreview = ~0ULL;
+    for (int i = 0; i < 700; ++i) {
+        atem_onLoop(cfg, tally);
+        if (tally.programMask != lastProgram || tally.previewMask != lastPreview) {
+            lastProgram = tally.programMask;
+            lastPreview = tally.previewMask;
+            printf("link=%s program=%u preview=%u inputs=%zu\n", atem_linkName(),
+                   tally.programInput, tally.previewInput, tally.inputs.size());
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    for (const auto& kv : tally.inputs) {
+        printf("input %u %s / %s enabled=%d\n", kv.first, kv.second.shortName.c_str(),
+               kv.second.longName.c_str(), kv.second.tallyEnabled);
+    }
+    printf("resends=%u link=%s direct=%d\n", atem_resends(), atem_linkName(), tally.atemDirect);
+    return 0;
+}
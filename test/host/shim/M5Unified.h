@@ -0,0 +1,62 @@
+#pragma once
+
+// Just enough of Arduino (String, Serial, millis) to build the network
+// modules on a Linux host. Not a general-purpose shim.
+
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+#include <cctype>
+#include <cmath>
+#include <chrono>
+#include <map>
+
+class String {
+public:
+    String() {}
+    String(const char* c) : _s(c ? c : "") {}
+    explicit String(uint32_t v) : _s(std::to_string(v)) {}
+
+    String& operator=(const char* c) { _s = c ? c : ""; return *this; }
+    bool operator==(const String& o) const { return _s == o._s; }
+    bool operator==(const char* c) const   { return _s == c; }
+    bool operator!=(const String& o) const { return _s != o._s; }
+    bool operator!=(const char* c) const   { return _s != c; }
+
+    unsigned    length() const { return _s.size(); }
+    const char* c_str() const  { return _s.c_str(); }
+
+    int indexOf(char c, int from) const {
+        size_t i = _s.find(c, from);
+        return i == std::string::npos ? -1 : static_cast<int>(i);
+    }
+    String substring(int from, int to) const {
+        String r;
+        r._s = _s.substr(from, to - from);
+        return r;
+    }
+    void trim() {
+        while (!_s.empty() && _s.back() == ' ') _s.pop_back();
+        while (!_s.empty() && _s[0] == ' ')     _s.erase(0, 1);
+    }
+    void toLowerCase() {
+        for (char& ch : _s) ch = static_cast<char>(tolower(ch));
+    }
+
+private:
+    std::string _s;
+};
+
+struct SerialShim {
+    void println(const char* text) { ::printf("%s\n", text); }
+    template <class... Args>
+    void printf(const char* fmt, Args... args) { ::printf(fmt, args...); }
+};
+static SerialShim Serial __attribute__((unused));
+
+inline uint32_t millis() {
+    using namespace std::chrono;
+    return static_cast<uint32_t>(
+        duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+}
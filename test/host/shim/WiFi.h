@@ -0,0 +1,24 @@
+#pragma once
+
+// Host stand-in for the Arduino WiFi class: always connected
+#include <arpa/inet.h>
+#include "M5Unified.h"
+
+enum { WL_CONNECTED = 3 };
+
+struct WiFiShim {
+    int status() { return WL_CONNECTED; }
+};
+static WiFiShim WiFi __attribute__((unused));
+
+struct IPAddress {
+    uint32_t addr = 0;
+
+    bool fromString(const String& s) {
+        in_addr a;
+        if (!inet_aton(s.c_str(), &a)) return false;
+        addr = a.s_addr;
+        return true;
+    }
+    operator uint32_t() const { return addr; }
+};
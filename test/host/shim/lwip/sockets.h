@@ -0,0 +1,8 @@
+#pragma once
+
+// Host stand-in for lwIP's BSD socket API: the POSIX one
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
@@ -0,0 +1,33 @@
+// Runs TslModule on UDP/TCP 8900 for ~3 s while tsl_send.py plays its
+// script, printing every tally / input table change, then the counters.
+
+#include "TslModule.h"
+#include <thread>
+
+int main() {
+    ConfigState cfg;
+    cfg.global.tslPort = 8900;
+    TallyState tally;
+
+    uint64_t lastProgram = ~0ULL, lastPreview = ~0ULL;
+    size_t   lastInputs  = SIZE_MAX;
+    for (int i = 0; i < 300; ++i) {
+        tsl_onLoop(cfg, tally);
+        if (tally.programMask != lastProgram || tally.previewMask != lastPreview ||
+            tally.inputs.size() != lastInputs) {
+            lastProgram = tally.programMask;
+            lastPreview = tally.previewMask;
+            lastInputs  = tally.inputs.size();
+            printf("umd=%d program=%llx preview=%llx inputs=%zu\n", tally.umdDirect,
+                   (unsigned long long)lastProgram, (unsigned long long)lastPreview, lastInputs);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    for (const auto& kv : tally.inputs) {
+        printf("input %u '%s' brightness=%u\n", kv.first, kv.second.shortName.c_str(),
+               kv.second.brightness);
+    }
+    printf("rx=%u rejected=%u\n", tsl_received(), tsl_rejected());
+    return 0;
+}
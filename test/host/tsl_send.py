@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+"""Plays a fixed TSL UMD script at 127.0.0.1:8900 for tsl_harness.
+
+- v3.1: 80 messages in one datagram, 1 on program, 2 on preview
+- v5.0 over UDP: program 3 at brightness 1, preview 1, a broadcast
+  brightness message, then a UTF-16 label for index 4
+- a malformed datagram (counted as rejected)
+- v5.0 over TCP, DLE/STX framed with a stuffed DLE in the label, sent one
+  byte at a time
+"""
+import socket
+import struct
+import time
+
+TARGET = ("127.0.0.1", 8900)
+
+
+def v31(address, control, text):
+    return bytes([0x80 | address, control]) + text.ljust(16).encode()
+
+
+def v5(messages, flags=0):
+    body = b"".join(struct.pack("<HHH", index, control, len(text)) + text
+                    for index, control, text in messages)
+    packet = struct.pack("<BBH", 0, flags, 0) + body
+    return struct.pack("<H", len(packet)) + packet
+
+
+def framed(packet):
+    return b"\xfe\x02" + packet.replace(b"\xfe", b"\xfe\xfe")
+
+
+udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+time.sleep(0.3)
+
+burst = b"".join(v31(a, 0x30 | (1 if a == 1 else 0) | (2 if a == 2 else 0), "CAM%d" % a)
+                 for a in range(80))
+udp.sendto(burst, TARGET)
+time.sleep(0.3)
+
+udp.sendto(v5([(1, (2 << 4) | (3 << 6), b"Left"),
+               (2, 3 << 6, b"Ctr"),
+               (3, 1 | (1 << 6), b"Wide"),
+               (0xFFFF, 3 << 6, b"")]), TARGET)
+time.sleep(0.3)
+udp.sendto(v5([(4, 3 << 6, "Ü4".encode("utf-16-le"))], flags=1), TARGET)
+time.sleep(0.3)
+
+udp.sendto(b"garbage", TARGET)
+time.sleep(0.3)
+
+tcp = socket.create_connection(TARGET)
+data = framed(v5([(2, 1 | (3 << 6), b"C\xfeT")])) + framed(v5([(1, 2 | (3 << 6), b"L")]))
+for i in range(len(data)):
+    tcp.send(data[i:i + 1])
+    time.sleep(0.002)
+time.sleep(0.5)
+tcp.close()
@@ -0,0 +1,26 @@
+// Runs UdpTallyModule on 239.255.77.1:5599 for ~5 s while
+// udp_tally_send.py cuts every second, printing every applied change,
+// then the counters.
+
+#include "UdpTallyModule.h"
+#include <thread>
+
+int main() {
+    ConfigState cfg;
+    cfg.global.udpTallyGroup = "239.255.77.1";
+    cfg.global.udpTallyPort  = 5599;
+    TallyState tally;
+
+    uint32_t lastSeq = 0;
+    for (int i = 0; i < 500; ++i) {
+        udpTally_onLoop(cfg, tally);
+        if (tally.fastSeq != lastSeq) {
+            lastSeq = tally.fastSeq;
+            printf("seq=%u program=%u preview=%u\n", tally.fastSeq,
+                   tally.programInput, tally.previewInput);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    printf("rx=%u rejected=%u\n", udpTally_received(), udpTally_rejected());
+    return 0;
+}
@@ -0,0 +1,38 @@
+#!/usr/bin/env python3
+"""Sends the §2.1.2 tally datagram to 239.255.77.1:5599 for udp_tally_harness.
+
+Cuts every second with a mid-second heartbeat (same seq), and sends one
+reordered (old seq) and one malformed datagram; the harness should end
+with rejected=2.
+
+    python3 udp_tally_send.py [interface]    # e.g. "lo"
+"""
+import socket
+import struct
+import sys
+import time
+
+GROUP, PORT = "239.255.77.1", 5599
+
+
+def datagram(seq, program, preview):
+    return struct.pack(">2sBBIBB2x", b"TL", 1, 0, seq, program, preview)
+
+
+s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+s.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, 1)
+s.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_LOOP, 1)
+if len(sys.argv) > 1:
+    s.setsockopt(socket.SOL_SOCKET, socket.SO_BINDTODEVICE, sys.argv[1].encode())
+
+time.sleep(0.3)
+seq, program, preview = 1, 1, 2
+for _ in range(4):
+    s.sendto(datagram(seq, program, preview), (GROUP, PORT))
+    time.sleep(0.5)
+    s.sendto(datagram(seq, program, preview), (GROUP, PORT))   # heartbeat
+    time.sleep(0.5)
+    seq, program, preview = seq + 1, preview, program
+
+s.sendto(datagram(seq - 3, 9, 9), (GROUP, PORT))   # reordered
+s.sendto(b"TL\x01\x00short", (GROUP, PORT))        # malformed
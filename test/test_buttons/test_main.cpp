@@ -0,0 +1,150 @@
+// Host tests for the button state machine and ISR debounce.
+// Run with: pio test -e native -f test_buttons
+
+#include <unity.h>
+#include "ButtonManager.h"
+
+static const uint32_t LONG_MS = 500;
+
+void setUp() {}
+void tearDown() {}
+
+// --- Short / long press ----------------------------------------
+
+static void test_short_press() {
+    ButtonStateMachine<ButtonID::A> sm;
+    sm.configure(LONG_MS, 0);
+
+    TEST_ASSERT_EQUAL(ButtonType::None, sm.onEdge(true, 1000));
+    TEST_ASSERT_EQUAL(ButtonType::None, sm.tick(1100));
+    TEST_ASSERT_EQUAL(ButtonType::ShortPress, sm.onEdge(false, 1200));
+    TEST_ASSERT_FALSE(sm.isDown());
+}
+
+static void test_long_press_fires_while_held() {
+    ButtonStateMachine<ButtonID::A> sm;
+    sm.configure(LONG_MS, 0);
+
+    sm.onEdge(true, 1000);
+    TEST_ASSERT_EQUAL(ButtonType::None, sm.tick(1499));
+    TEST_ASSERT_EQUAL(ButtonType::LongPress, sm.tick(1500));
+    TEST_ASSERT_EQUAL(ButtonType::None, sm.tick(1600));        // once only
+    TEST_ASSERT_EQUAL(ButtonType::None, sm.onEdge(false, 2000)); // release is silent
+    TEST_ASSERT_FALSE(sm.isDown());
+}
+
+static void test_long_press_between_ticks() {
+    // Loop stalled past the threshold: the release still reports LongPress
+    ButtonStateMachine<ButtonID::A> sm;
+    sm.configure(LONG_MS, 0);
+
+    sm.onEdge(true, 1000);
+    TEST_ASSERT_EQUAL(ButtonType::LongPress, sm.onEdge(false, 1600));
+}
+
+static void test_double_click() {
+    ButtonStateMachine<ButtonID::A> sm;
+    sm.configure(LONG_MS, 250);
+
+    sm.onEdge(true, 1000);
+    TEST_ASSERT_EQUAL(ButtonType::None, sm.onEdge(false, 1050));
+    TEST_ASSERT_EQUAL(ButtonType::None, sm.tick(1100));
+    sm.onEdge(true, 1150);
+    TEST_ASSERT_EQUAL(ButtonType::DoubleClick, sm.onEdge(false, 1200));
+
+    // A single click is only decided once the window has passed
+    sm.onEdge(true, 2000);
+    sm.onEdge(false, 2050);
+    TEST_ASSERT_EQUAL(ButtonType::None, sm.tick(2299));
+    TEST_ASSERT_EQUAL(ButtonType::ShortPress, sm.tick(2300));
+}
+
+// --- Chord -----------------------------------------------------
+
+static void test_chord_suppresses_both() {
+    // What ButtonManager::handleEdge() does when B goes down while A is
+    // still undecided
+    ButtonStateMachine<ButtonID::A> a;
+    ButtonStateMachine<ButtonID::B> b;
+    a.configure(LONG_MS, 0);
+    b.configure(LONG_MS, 0);
+
+    a.onEdge(true, 1000);
+    TEST_ASSERT_TRUE(a.isPending());
+    b.onEdge(true, 1050);
+    a.suppress();
+    b.suppress();
+
+    // Neither long press nor release may fire on its own afterwards
+    TEST_ASSERT_EQUAL(ButtonType::None, a.tick(2000));
+    TEST_ASSERT_EQUAL(ButtonType::None, b.tick(2000));
+    TEST_ASSERT_EQUAL(ButtonType::None, a.onEdge(false, 2100));
+    TEST_ASSERT_EQUAL(ButtonType::None, b.onEdge(false, 2150));
+
+    // Back to normal once released
+    a.onEdge(true, 3000);
+    TEST_ASSERT_EQUAL(ButtonType::ShortPress, a.onEdge(false, 3100));
+}
+
+static void test_no_chord_after_long_press() {
+    ButtonStateMachine<ButtonID::A> a;
+    a.configure(LONG_MS, 0);
+
+    a.onEdge(true, 1000);
+    a.tick(1500);                       // long press decided
+    TEST_ASSERT_FALSE(a.isPending());   // B now would not form a chord
+    TEST_ASSERT_TRUE(a.isDown());
+}
+
+// --- Debounce ----------------------------------------------------
+
+static void test_debounce_drops_bounce() {
+    bool    lastDown = false;
+    int64_t lastUs   = 0;
+
+    TEST_ASSERT_TRUE(debounceEdge(true, 100000, lastDown, lastUs));
+    TEST_ASSERT_FALSE(debounceEdge(false, 105000, lastDown, lastUs));   // bounce
+    TEST_ASSERT_TRUE(lastDown);
+    TEST_ASSERT_TRUE(debounceEdge(false, 100000 + DEBOUNCE_DEFAULT_US, lastDown, lastUs));
+    TEST_ASSERT_FALSE(lastDown);
+}
+
+static void test_debounce_ignores_same_level() {
+    // Spurious GPIO39 interrupts re-read the same level
+    bool    lastDown = false;
+    int64_t lastUs   = 0;
+
+    TEST_ASSERT_FALSE(debounceEdge(false, 500000, lastDown, lastUs));
+    TEST_ASSERT_EQUAL_INT64(0, lastUs);
+}
+
+// --- Edge queue ----------------------------------------------------
+
+static void test_edge_queue_full_counts_drops() {
+    SpscQueue<ButtonEdge, 4> q;
+    ButtonEdge e;
+    for (uint32_t i = 0; i < 4; ++i) {
+        e.atMs = i;
+        TEST_ASSERT_TRUE(q.push(e));
+    }
+    TEST_ASSERT_FALSE(q.push(e));
+    TEST_ASSERT_EQUAL_UINT32(1, q.dropped());
+
+    ButtonEdge out;
+    TEST_ASSERT_TRUE(q.pop(out));
+    TEST_ASSERT_EQUAL_UINT32(0, out.atMs);   // FIFO order
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_short_press);
+    RUN_TEST(test_long_press_fires_while_held);
+    RUN_TEST(test_long_press_between_ticks);
+    RUN_TEST(test_double_click);
+    RUN_TEST(test_chord_suppresses_both);
+    RUN_TEST(test_no_chord_after_long_press);
+    RUN_TEST(test_debounce_drops_bounce);
+    RUN_TEST(test_debounce_ignores_same_level);
+    RUN_TEST(test_edge_queue_full_counts_drops);
+    return UNITY_END();
+}
@@ -0,0 +1,108 @@
+// Host benchmark: sanctuary/atem/inputs as JSON vs MessagePack.
+// Prints payload bytes and parse time per message for a 20-input map in
+// the §2.2 format, using the same ArduinoJson calls as MqttRouter.
+// Run with: pio test -e native -f test_inputs_codec -v
+//
+// Times are host times: compare the two encodings, not absolute values.
+
+#include <unity.h>
+#include <ArduinoJson.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+static const int INPUT_COUNT = 20;
+static const int PARSE_RUNS  = 2000;
+
+static const char* const LABELS[INPUT_COUNT][2] = {
+    { "CTR",  "Center Cam" },          { "LFT",  "Left Cam" },
+    { "RGT",  "Right Cam" },           { "NWC",  "North West Corner" },
+    { "NEC",  "North East Corner" },   { "BAL",  "Balcony Wide" },
+    { "PUL",  "Pulpit Close" },        { "CHR",  "Choir Loft" },
+    { "ORG",  "Organ Console" },       { "BPT",  "Baptistry" },
+    { "LOB",  "Lobby" },               { "KID",  "Kids Wing Feed" },
+    { "PC1",  "Slides PC" },           { "PC2",  "Lyrics PC" },
+    { "MP1",  "Media Player 1" },      { "MP2",  "Media Player 2" },
+    { "ZOOM", "Zoom Return" },         { "WALK", "Walk-in Loop" },
+    { "BLK",  "Black" },               { "BARS", "Color Bars" },
+};
+
+// The map as Companion publishes it. boolEnabled: tally_enabled as a
+// bool (allowed on the MessagePack topics) instead of "TRUE"/"FALSE".
+static void buildInputs(JsonDocument& doc, bool boolEnabled) {
+    doc.clear();
+    for (int i = 0; i < INPUT_COUNT; ++i) {
+        JsonObject in = doc[std::to_string(i + 1)].to<JsonObject>();
+        in["id"]         = i + 1;
+        in["short_name"] = LABELS[i][0];
+        in["long_name"]  = LABELS[i][1];
+        if (boolEnabled) {
+            in["tally_enabled"] = (i < 12);
+        } else {
+            in["tally_enabled"] = (i < 12) ? "TRUE" : "FALSE";
+        }
+    }
+}
+
+template <typename Parse>
+static double usPerParse(Parse parse) {
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < PARSE_RUNS; ++i) {
+        TEST_ASSERT_FALSE(parse());
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(t1 - t0).count() / PARSE_RUNS;
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_msgpack_decodes_to_same_map() {
+    JsonDocument src;
+    buildInputs(src, false);
+    std::string json, msgpack;
+    serializeJson(src, json);
+    serializeMsgPack(src, msgpack);
+
+    JsonDocument a, b;
+    TEST_ASSERT_FALSE(deserializeJson(a, json.data(), json.size()));
+    TEST_ASSERT_FALSE(deserializeMsgPack(b, msgpack.data(), msgpack.size()));
+    TEST_ASSERT_TRUE(a.as<JsonVariantConst>() == b.as<JsonVariantConst>());
+}
+
+static void report(const char* name, bool boolEnabled) {
+    JsonDocument src;
+    buildInputs(src, boolEnabled);
+    std::string json, msgpack;
+    serializeJson(src, json);
+    serializeMsgPack(src, msgpack);
+
+    JsonDocument doc;
+    const double jsonUs = usPerParse([&] {
+        return bool(deserializeJson(doc, json.data(), json.size()));
+    });
+    const double packUs = usPerParse([&] {
+        return bool(deserializeMsgPack(doc, msgpack.data(), msgpack.size()));
+    });
+
+    char line[160];
+    snprintf(line, sizeof(line),
+             "%s: json %u B %.2f us/parse, msgpack %u B (%+.0f%%) %.2f us/parse (%+.0f%%)",
+             name, (unsigned)json.size(), jsonUs, (unsigned)msgpack.size(),
+             100.0 * ((double)msgpack.size() / json.size() - 1.0),
+             packUs, 100.0 * (packUs / jsonUs - 1.0));
+    TEST_MESSAGE(line);
+
+    TEST_ASSERT_LESS_THAN(json.size(), msgpack.size());
+}
+
+static void test_report_string_enabled() { report("20 inputs, \"TRUE\"/\"FALSE\"", false); }
+static void test_report_bool_enabled()   { report("20 inputs, bool", true); }
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_msgpack_decodes_to_same_map);
+    RUN_TEST(test_report_string_enabled);
+    RUN_TEST(test_report_bool_enabled);
+    return UNITY_END();
+}